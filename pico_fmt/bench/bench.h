@@ -0,0 +1,54 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// \brief Shared helpers for the host-side benchmark programs.
+//
+// These run on the build host rather than on the target, so the
+// absolute numbers they report are only useful for comparing one
+// input (or one build) to another.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PICO_FMT_BENCH_H
+#define PICO_FMT_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+// An output function that discards its input; the `arg` is a
+// `size_t *` byte counter (or NULL).
+static inline void bench_discard(char character, void *arg) {
+    (void) character;
+    if (arg)
+        (*(size_t *) arg)++;
+}
+
+// Keep the compiler from optimizing away a value that is otherwise
+// unused.
+#define bench_keep(v) __asm__ volatile("" : : "r"(v) : "memory")
+
+// Run `stmt` `reps` times and evaluate to the fastest run in
+// nanoseconds; the minimum is the least noisy estimate of the
+// intrinsic cost on a shared host.
+#define bench_min_ns(reps, stmt) ({            \
+    uint64_t _best = UINT64_MAX;               \
+    for (unsigned _i = 0; _i < (reps); _i++) { \
+        uint64_t _beg = bench_now_ns();        \
+        stmt;                                  \
+        uint64_t _dur = bench_now_ns() - _beg; \
+        if (_dur < _best)                      \
+            _best = _dur;                      \
+    }                                          \
+    _best;                                     \
+})
+
+#endif // PICO_FMT_BENCH_H
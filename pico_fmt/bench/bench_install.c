@@ -0,0 +1,165 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// \brief Benchmark of fmt_install() custom specifiers, compared with
+//        the built-in conversions.
+//
+// Each row renders a format to a discarding output function, and is
+// compared with a baseline row that produces the same output using
+// only built-in conversions; so the "delta" column is the overhead
+// that going through a custom specifier adds.  The rows measure:
+//
+//  - dispatch: a handler that does the minimum (fetch one argument,
+//    emit one byte), against the built-in `%c`.
+//
+//  - nesting: a handler that re-enters the engine with
+//    fmt_state_printf(), against the built-in conversion it wraps; at
+//    increasing depths, to show the per-level cost.
+//
+//  - per-byte: handlers that emit an N-byte string with a
+//    fmt_state_putchar() loop or with fmt_state_puts(), against the
+//    built-in `%s`.
+//
+// Usage: bench_install [-n reps]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pico/fmt_install.h"
+#include "pico/fmt_printf.h"
+
+#include "bench.h"
+
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+// How many calls each timed sample makes; this amortizes the cost of
+// reading the clock.
+#ifndef BENCH_BATCH
+#define BENCH_BATCH 256
+#endif
+
+static unsigned reps = 64;
+
+// handlers ///////////////////////////////////////////////////////////////////
+
+// %C: like %c, but the least that a custom specifier can do.
+static void conv_C(struct fmt_state *state) {
+    fmt_state_putchar(state, (char) va_arg(*state->args, int));
+}
+
+// %D: %d, by way of a nested fmt_state_printf().
+static void conv_D(struct fmt_state *state) {
+    fmt_state_printf(state, "%d", va_arg(*state->args, int));
+}
+
+// %U: a chain of nested %U's, `depth` deep, ending in a %d.
+static void conv_U(struct fmt_state *state) {
+    int depth = va_arg(*state->args, int);
+    int value = va_arg(*state->args, int);
+    if (depth > 1)
+        fmt_state_printf(state, "%U", depth - 1, value);
+    else
+        fmt_state_printf(state, "%d", value);
+}
+
+// %Z: %s, with a fmt_state_putchar() loop.
+static void conv_Z(struct fmt_state *state) {
+    for (const char *str = va_arg(*state->args, const char *); *str; str++)
+        fmt_state_putchar(state, *str);
+}
+
+// %Y: %s, with fmt_state_puts().
+static void conv_Y(struct fmt_state *state) {
+    fmt_state_puts(state, va_arg(*state->args, const char *));
+}
+
+// timing /////////////////////////////////////////////////////////////////////
+
+static uint64_t baseline_ns;
+
+// Print one row; `nbytes` is the output length of a single call.
+static void row(const char *name, bool is_baseline, uint64_t batch_ns, size_t nbytes) {
+    double per_call = (double) batch_ns / BENCH_BATCH;
+    if (is_baseline)
+        baseline_ns = batch_ns;
+    double delta = per_call - (double) baseline_ns / BENCH_BATCH;
+    printf("  %-32s %9.1f ns/call %+9.1f ns %8.2f ns/byte\n",
+           name, per_call, delta, per_call / (double) (nbytes ? nbytes : 1));
+}
+
+#define BENCH(name, is_baseline, ...)                                \
+    do {                                                             \
+        size_t _nbytes = 0;                                          \
+        uint64_t _ns = bench_min_ns(reps, {                          \
+            _nbytes = 0;                                             \
+            for (unsigned _j = 0; _j < BENCH_BATCH; _j++)            \
+                fmt_fctprintf(bench_discard, &_nbytes, __VA_ARGS__); \
+        });                                                          \
+        row(name, is_baseline, _ns, _nbytes / BENCH_BATCH);          \
+    } while (0)
+
+// main ///////////////////////////////////////////////////////////////////////
+
+static char strbuf[4096];
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                reps = (unsigned) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n reps]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    fmt_install('C', conv_C);
+    fmt_install('D', conv_D);
+    fmt_install('U', conv_U);
+    fmt_install('Z', conv_Z);
+    fmt_install('Y', conv_Y);
+
+    printf("dispatch:\n");
+    BENCH("%c (built-in)", true, "%c", 'x');
+    BENCH("%C", false, "%C", 'x');
+    BENCH("%c%c%c%c (built-in)", true, "%c%c%c%c", 'a', 'b', 'c', 'd');
+    BENCH("%C%C%C%C", false, "%C%C%C%C", 'a', 'b', 'c', 'd');
+
+    printf("nesting:\n");
+    BENCH("%d (built-in)", true, "%d", -123456);
+    BENCH("%D", false, "%D", -123456);
+    static const int depths[] = {1, 2, 4, 8};
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "%%U depth=%d", depths[i]);
+        BENCH(name, false, "%U", depths[i], -123456);
+    }
+
+    printf("per-byte:\n");
+    static const size_t lens[] = {1, 16, 256, 4095};
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        memset(strbuf, 'x', lens[i]);
+        strbuf[lens[i]] = '\0';
+        char name[64];
+        snprintf(name, sizeof(name), "%%s (built-in) len=%zu", lens[i]);
+        BENCH(name, true, "%s", strbuf);
+        snprintf(name, sizeof(name), "%%Z (putchar loop) len=%zu", lens[i]);
+        BENCH(name, false, "%Z", strbuf);
+        snprintf(name, sizeof(name), "%%Y (puts) len=%zu", lens[i]);
+        BENCH(name, false, "%Y", strbuf);
+    }
+
+    return 0;
+}
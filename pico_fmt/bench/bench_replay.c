@@ -0,0 +1,541 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// \brief Replay a recorded log trace through fmt_vfctprintf().
+//
+// Microbenchmarks of single conversions miss how formats mix in real
+// use; this replays a whole trace, record by record, through each of
+// several output functions, and reports throughput, bytes/sec, and the
+// per-record latency distribution.  It is the acceptance benchmark
+// for changes to the engine: run it before and after.
+//
+// A trace file has one record per line; blank lines and lines
+// starting with `#` are ignored.  A record is a double-quoted format
+// string (with C escapes), followed by the arguments, each written as
+// `TYPE:VALUE`, where TYPE is the class that the C calling convention
+// passes the argument as:
+//
+//     i:  int (including promoted char, short, and unsigned int)
+//     l:  long (and unsigned long)
+//     q:  long long (and unsigned long long)
+//     f:  double
+//     s:  a string, double-quoted with C escapes
+//     p:  a pointer, as an integer
+//
+// `pico_fmt/bench/trace_synthetic.txt` is a bundled synthetic trace.
+//
+// Records with up to REPLAY_MAX_DIRECT arguments are replayed with a
+// single call; longer records are split at conversion boundaries in
+// to several calls that each take at most that many arguments.
+//
+// Usage: bench_replay [-v] [-n passes] [-k sink] TRACEFILE
+//
+// `-v` prints the rendered trace once before benchmarking, to check
+// that the trace was parsed as intended.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pico/fmt_printf.h"
+
+#include "bench.h"
+
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+#define REPLAY_MAX_ARGS   32
+#define REPLAY_MAX_DIRECT 4
+
+// trace records //////////////////////////////////////////////////////////////
+
+enum arg_class {
+    CLASS_INT,
+    CLASS_LONG,
+    CLASS_LONG_LONG,
+    CLASS_DOUBLE,
+    CLASS_PTR,
+    NUM_CLASSES,
+};
+
+union arg {
+    int i;
+    long l;
+    long long q;
+    double f;
+    const void *p;
+};
+
+// One call to the engine.
+struct call {
+    char *fmt;
+    unsigned code; // see replay_call()
+    unsigned nargs;
+    const union arg *args;
+};
+
+struct record {
+    union arg args[REPLAY_MAX_ARGS];
+    unsigned nargs;
+    enum arg_class classes[REPLAY_MAX_ARGS];
+
+    struct call calls[REPLAY_MAX_ARGS];
+    unsigned ncalls;
+};
+
+static struct {
+    struct record *records;
+    size_t nrecords;
+    size_t ncalls;
+} trace;
+
+// Parse a double-quoted C string at `*p` in-place, advancing `*p`
+// past it; returns the NUL-terminated result, or NULL on error.
+static char *parse_quoted(char **p) {
+    char *in = *p;
+    if (*in != '"')
+        return NULL;
+    char *ret = ++in;
+    char *out = ret;
+    while (*in != '"') {
+        if (!*in)
+            return NULL;
+        if (*in != '\\') {
+            *(out++) = *(in++);
+            continue;
+        }
+        in++;
+        switch (*in) {
+            case 'n':
+                *(out++) = '\n';
+                in++;
+                break;
+            case 't':
+                *(out++) = '\t';
+                in++;
+                break;
+            case 'r':
+                *(out++) = '\r';
+                in++;
+                break;
+            case '0':
+                *(out++) = '\0';
+                in++;
+                break;
+            case 'x':
+                *(out++) = (char) strtoul(in + 1, &in, 16);
+                break;
+            case '\0':
+                return NULL;
+            default:
+                *(out++) = *(in++);
+                break;
+        }
+    }
+    *p = in + 1;
+    *out = '\0';
+    return ret;
+}
+
+// How many arguments the conversion at `*format` (just past the `%`)
+// consumes; advances `*format` past it.
+static unsigned conversion_nargs(const char **format) {
+    const char *p = *format;
+    unsigned n = 0;
+    while (*p && strchr("0-+ #", *p))
+        p++;
+    if (*p == '*') {
+        n++;
+        p++;
+    }
+    while ('0' <= *p && *p <= '9')
+        p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            n++;
+            p++;
+        }
+        while ('0' <= *p && *p <= '9')
+            p++;
+    }
+    while (*p && strchr("hljzt", *p))
+        p++;
+    if (*p && *p != '%')
+        n++;
+    if (*p)
+        p++;
+    *format = p;
+    return n;
+}
+
+static unsigned call_code(const enum arg_class *classes, unsigned nargs) {
+    // The number of codes used by all of the shorter signatures, plus
+    // this signature read as a base-NUM_CLASSES number.
+    unsigned offset = 0, code = 0, span = 1;
+    for (unsigned i = 0; i < nargs; i++) {
+        offset += span;
+        span *= NUM_CLASSES;
+        code = code * NUM_CLASSES + (unsigned) classes[i];
+    }
+    return offset + code;
+}
+
+// Split `rec` (whose format is `fmt`) in to calls.
+static bool record_split(struct record *rec, const char *fmt) {
+    unsigned argi = 0;
+    const char *beg = fmt;
+    unsigned beg_argi = 0;
+    for (const char *p = fmt; *p;) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        const char *conv = p++;
+        unsigned n = conversion_nargs(&p);
+        if (argi + n - beg_argi > REPLAY_MAX_DIRECT && conv != beg) {
+            // Cut before this conversion.
+            rec->calls[rec->ncalls++] = (struct call){
+                .fmt = strndup(beg, (size_t) (conv - beg)),
+                .code = call_code(&rec->classes[beg_argi], argi - beg_argi),
+                .nargs = argi - beg_argi,
+                .args = &rec->args[beg_argi],
+            };
+            beg = conv;
+            beg_argi = argi;
+        }
+        argi += n;
+        if (argi - beg_argi > REPLAY_MAX_DIRECT)
+            return false; // a single conversion with too many arguments
+    }
+    if (argi != rec->nargs)
+        return false;
+    rec->calls[rec->ncalls++] = (struct call){
+        .fmt = strdup(beg),
+        .code = call_code(&rec->classes[beg_argi], argi - beg_argi),
+        .nargs = argi - beg_argi,
+        .args = &rec->args[beg_argi],
+    };
+    return true;
+}
+
+static bool parse_record(char *line, struct record *rec) {
+    char *p = line;
+    char *fmt = parse_quoted(&p);
+    if (!fmt)
+        return false;
+    rec->nargs = 0;
+    rec->ncalls = 0;
+    for (;;) {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (!*p || *p == '\n')
+            break;
+        if (rec->nargs == REPLAY_MAX_ARGS || p[1] != ':')
+            return false;
+        union arg *arg = &rec->args[rec->nargs];
+        char type = p[0];
+        p += 2;
+        switch (type) {
+            case 'i':
+                rec->classes[rec->nargs] = CLASS_INT;
+                arg->i = (int) strtoll(p, &p, 0);
+                break;
+            case 'l':
+                rec->classes[rec->nargs] = CLASS_LONG;
+                arg->l = (long) strtoull(p, &p, 0);
+                break;
+            case 'q':
+                rec->classes[rec->nargs] = CLASS_LONG_LONG;
+                arg->q = (long long) strtoull(p, &p, 0);
+                break;
+            case 'f':
+                rec->classes[rec->nargs] = CLASS_DOUBLE;
+                arg->f = strtod(p, &p);
+                break;
+            case 's':
+                rec->classes[rec->nargs] = CLASS_PTR;
+                arg->p = parse_quoted(&p);
+                if (!arg->p)
+                    return false;
+                break;
+            case 'p':
+                rec->classes[rec->nargs] = CLASS_PTR;
+                arg->p = (const void *) (uintptr_t) strtoull(p, &p, 0);
+                break;
+            default:
+                return false;
+        }
+        rec->nargs++;
+    }
+    return record_split(rec, fmt);
+}
+
+static void load_trace(const char *filename) {
+    FILE *fh = fopen(filename, "r");
+    if (!fh) {
+        perror(filename);
+        exit(1);
+    }
+    size_t cap = 0;
+    char *line = NULL;
+    size_t linecap = 0;
+    for (unsigned lineno = 1; getline(&line, &linecap, fh) >= 0; lineno++) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\0')
+            continue;
+        if (trace.nrecords == cap) {
+            cap = cap ? cap * 2 : 64;
+            trace.records = realloc(trace.records, cap * sizeof(trace.records[0]));
+        }
+        struct record *rec = &trace.records[trace.nrecords];
+        // The record keeps pointers in to the line (for string arguments).
+        if (!parse_record(strdup(line), rec)) {
+            fprintf(stderr, "%s:%u: could not parse record\n", filename, lineno);
+            exit(1);
+        }
+        trace.nrecords++;
+        trace.ncalls += rec->ncalls;
+    }
+    free(line);
+    fclose(fh);
+}
+
+// calling ////////////////////////////////////////////////////////////////////
+
+// Generate a `case` for every signature of up to REPLAY_MAX_DIRECT
+// arguments, so that each argument is passed as its real type.  Each
+// nesting level needs its own copy of the class list, as a macro
+// cannot expand itself.
+#define _CLASSES_A(X, ...)             \
+    X(CLASS_INT, i, __VA_ARGS__)       \
+    X(CLASS_LONG, l, __VA_ARGS__)      \
+    X(CLASS_LONG_LONG, q, __VA_ARGS__) \
+    X(CLASS_DOUBLE, f, __VA_ARGS__)    \
+    X(CLASS_PTR, p, __VA_ARGS__)
+#define _CLASSES_B(X, ...)             \
+    X(CLASS_INT, i, __VA_ARGS__)       \
+    X(CLASS_LONG, l, __VA_ARGS__)      \
+    X(CLASS_LONG_LONG, q, __VA_ARGS__) \
+    X(CLASS_DOUBLE, f, __VA_ARGS__)    \
+    X(CLASS_PTR, p, __VA_ARGS__)
+#define _CLASSES_C(X, ...)             \
+    X(CLASS_INT, i, __VA_ARGS__)       \
+    X(CLASS_LONG, l, __VA_ARGS__)      \
+    X(CLASS_LONG_LONG, q, __VA_ARGS__) \
+    X(CLASS_DOUBLE, f, __VA_ARGS__)    \
+    X(CLASS_PTR, p, __VA_ARGS__)
+#define _CLASSES_D(X, ...)             \
+    X(CLASS_INT, i, __VA_ARGS__)       \
+    X(CLASS_LONG, l, __VA_ARGS__)      \
+    X(CLASS_LONG_LONG, q, __VA_ARGS__) \
+    X(CLASS_DOUBLE, f, __VA_ARGS__)    \
+    X(CLASS_PTR, p, __VA_ARGS__)
+
+#define _N         NUM_CLASSES
+#define _CALL(...) fmt_fctprintf(fct, arg, call->fmt, __VA_ARGS__)
+
+#define _CASE1(c0, m0, ...) \
+    case 1 + c0:            \
+        _CALL(a[0].m0);     \
+        break;
+#define _CASE2_(c1, m1, c0, m0)   \
+    case 1 + _N + (c0 * _N + c1): \
+        _CALL(a[0].m0, a[1].m1);  \
+        break;
+#define _CASE2(c0, m0, ...) _CLASSES_B(_CASE2_, c0, m0)
+#define _CASE3__(c2, m2, c0, m0, c1, m1)                  \
+    case 1 + _N + (_N * _N) + ((c0 * _N + c1) * _N + c2): \
+        _CALL(a[0].m0, a[1].m1, a[2].m2);                 \
+        break;
+#define _CASE3_(c1, m1, c0, m0) _CLASSES_C(_CASE3__, c0, m0, c1, m1)
+#define _CASE3(c0, m0, ...)     _CLASSES_B(_CASE3_, c0, m0)
+#define _CASE4___(c3, m3, c0, m0, c1, m1, c2, m2)                                      \
+    case 1 + _N + (_N * _N) + (_N * _N * _N) + (((c0 * _N + c1) * _N + c2) * _N + c3): \
+        _CALL(a[0].m0, a[1].m1, a[2].m2, a[3].m3);                                     \
+        break;
+#define _CASE4__(c2, m2, c0, m0, c1, m1) _CLASSES_D(_CASE4___, c0, m0, c1, m1, c2, m2)
+#define _CASE4_(c1, m1, c0, m0)          _CLASSES_C(_CASE4__, c0, m0, c1, m1)
+#define _CASE4(c0, m0, ...)              _CLASSES_B(_CASE4_, c0, m0)
+
+static void replay_call(fmt_fct_t fct, void *arg, const struct call *call) {
+    const union arg *a = call->args;
+    switch (call->code) {
+        case 0:
+            fmt_fctprintf(fct, arg, call->fmt);
+            break;
+            _CLASSES_A(_CASE1, )
+            _CLASSES_A(_CASE2, )
+            _CLASSES_A(_CASE3, )
+            _CLASSES_A(_CASE4, )
+        default:
+            abort();
+    }
+}
+
+// sinks //////////////////////////////////////////////////////////////////////
+
+// Every sink counts the bytes it is given, so that the counting cost
+// is the same for all of them.
+static size_t sink_bytes;
+
+// A linear buffer that is reset for each record, like snprintf().
+static struct {
+    char buf[1024];
+    size_t len;
+} sink_buffer;
+
+static void out_buffer(char character, void *arg) {
+    (void) arg;
+    sink_bytes++;
+    if (sink_buffer.len < sizeof(sink_buffer.buf))
+        sink_buffer.buf[sink_buffer.len] = character;
+    sink_buffer.len++;
+}
+
+// A power-of-two ring that is never reset, like a log ring or a UART
+// TX queue.
+static struct {
+    char buf[4096];
+    size_t head;
+} sink_ring;
+
+static void out_ring(char character, void *arg) {
+    (void) arg;
+    sink_bytes++;
+    sink_ring.buf[sink_ring.head++ % sizeof(sink_ring.buf)] = character;
+}
+
+// stdio, going to /dev/null.
+static void out_stdio(char character, void *arg) {
+    sink_bytes++;
+    putc(character, (FILE *) arg);
+}
+
+static void out_discard(char character, void *arg) {
+    (void) character;
+    (void) arg;
+    sink_bytes++;
+}
+
+struct sink {
+    const char *name;
+    fmt_fct_t fct;
+    void *arg;
+};
+
+static struct sink sinks[] = {
+    {"discard", out_discard, NULL},
+    {"buffer", out_buffer, NULL},
+    {"ring", out_ring, NULL},
+    {"stdio", out_stdio, NULL},
+};
+
+// main ///////////////////////////////////////////////////////////////////////
+
+static int cmp_u64(const void *_a, const void *_b) {
+    uint64_t a = *(const uint64_t *) _a;
+    uint64_t b = *(const uint64_t *) _b;
+    return (a > b) - (a < b);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, double pct) {
+    size_t i = (size_t) (pct / 100.0 * (double) (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static void replay(const struct sink *sink, unsigned passes) {
+    size_t nsamples = trace.nrecords * passes;
+    uint64_t *samples = malloc(nsamples * sizeof(samples[0]));
+    size_t bytes_beg = sink_bytes;
+    uint64_t total_ns = 0;
+
+    for (unsigned pass = 0; pass < passes; pass++) {
+        for (size_t r = 0; r < trace.nrecords; r++) {
+            const struct record *rec = &trace.records[r];
+            sink_buffer.len = 0;
+            uint64_t beg = bench_now_ns();
+            for (unsigned c = 0; c < rec->ncalls; c++)
+                replay_call(sink->fct, sink->arg, &rec->calls[c]);
+            uint64_t dur = bench_now_ns() - beg;
+            samples[pass * trace.nrecords + r] = dur;
+            total_ns += dur;
+        }
+    }
+    size_t nbytes = sink_bytes - bytes_beg;
+
+    qsort(samples, nsamples, sizeof(samples[0]), cmp_u64);
+    double secs = (double) total_ns / 1e9;
+    printf("  %-8s %10.0f rec/s %10.0f call/s %8.2f MB/s | p50 %6llu p90 %6llu p99 %6llu p99.9 %6llu max %7llu ns\n",
+           sink->name,
+           (double) nsamples / secs,
+           (double) (trace.ncalls * passes) / secs,
+           (double) nbytes / secs / 1e6,
+           (unsigned long long) percentile(samples, nsamples, 50),
+           (unsigned long long) percentile(samples, nsamples, 90),
+           (unsigned long long) percentile(samples, nsamples, 99),
+           (unsigned long long) percentile(samples, nsamples, 99.9),
+           (unsigned long long) samples[nsamples - 1]);
+    free(samples);
+}
+
+static void usage(const char *arg0) {
+    fprintf(stderr, "Usage: %s [-v] [-n passes] [-k sink] TRACEFILE\n", arg0);
+    exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned passes = 100;
+    const char *only = NULL;
+    bool verbose = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "vn:k:")) != -1) {
+        switch (opt) {
+            case 'n':
+                passes = (unsigned) strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                only = optarg;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind + 1 != argc || !passes)
+        usage(argv[0]);
+
+    load_trace(argv[optind]);
+    if (!trace.nrecords) {
+        fprintf(stderr, "%s: no records\n", argv[optind]);
+        return 1;
+    }
+
+    FILE *devnull = fopen("/dev/null", "w");
+    if (!devnull) {
+        perror("/dev/null");
+        return 1;
+    }
+    sinks[3].arg = devnull;
+
+    if (verbose)
+        for (size_t r = 0; r < trace.nrecords; r++)
+            for (unsigned c = 0; c < trace.records[r].ncalls; c++)
+                replay_call(out_stdio, stdout, &trace.records[r].calls[c]);
+
+    printf("%s: %zu records, %zu calls, %u passes\n", argv[optind], trace.nrecords, trace.ncalls, passes);
+    for (size_t i = 0; i < sizeof(sinks) / sizeof(sinks[0]); i++)
+        if (!only || !strcmp(only, sinks[i].name))
+            replay(&sinks[i], passes);
+
+    fclose(devnull);
+    return 0;
+}
@@ -0,0 +1,303 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// \brief Empirical worst-case-execution-time search.
+//
+// `./build-aux/measure --wcet` computes a static upper bound on the
+// cycles each conversion can take; this program is its empirical
+// counterpart.  For each conversion it does a random-restart
+// hill-climb over the flags, width, precision, size modifier, and
+// argument value, looking for the input that takes the longest to
+// render (per output byte, so that it does not simply learn to max
+// out the width).  It reports the slowest input that it found for
+// each conversion, which is useful both as a sanity check of the
+// static bound's shape and as a regression workload.
+//
+// Usage: wcet_search [-S seed] [-r restarts] [-s steps] [-w max_width] [-p max_precision]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pico/fmt_printf.h"
+
+#include "bench.h"
+
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+// How many times each candidate is run; the fastest run is its time.
+#ifndef WCET_REPS
+#define WCET_REPS 32
+#endif
+
+static struct {
+    unsigned seed;
+    unsigned restarts;
+    unsigned steps;
+    int max_width;
+    int max_precision;
+} opts = {
+    .seed = 1,
+    .restarts = 8,
+    .steps = 200,
+    .max_width = 64,
+    .max_precision = 40,
+};
+
+// candidates /////////////////////////////////////////////////////////////////
+
+struct conversion {
+    char specifier;
+    const char *const *sizes; // NULL-terminated
+    enum { ARG_INT, ARG_DOUBLE, ARG_STR, ARG_PTR, ARG_NONE } type;
+};
+
+static const char *const sizes_int[] = {"", "hh", "h", "l", "ll", "j", "z", "t", NULL};
+static const char *const sizes_none[] = {"", NULL};
+
+static const struct conversion conversions[] = {
+    {'d', sizes_int, ARG_INT},
+    {'u', sizes_int, ARG_INT},
+    {'x', sizes_int, ARG_INT},
+    {'o', sizes_int, ARG_INT},
+    {'b', sizes_int, ARG_INT},
+    {'c', sizes_none, ARG_INT},
+    {'s', sizes_none, ARG_STR},
+    {'p', sizes_none, ARG_PTR},
+    {'%', sizes_none, ARG_NONE},
+    {'f', sizes_none, ARG_DOUBLE},
+    {'e', sizes_none, ARG_DOUBLE},
+    {'g', sizes_none, ARG_DOUBLE},
+};
+
+static const char flagchars[] = "0-+ #";
+
+struct candidate {
+    unsigned flags; // bitmask over flagchars
+    int width;      // -1 for none
+    int precision;  // -1 for none
+    unsigned size;  // index in to conversion->sizes
+    uint64_t ival;
+    double dval;
+    unsigned slen;
+};
+
+static char strbuf[4096];
+
+static unsigned rnd(unsigned n) {
+    return n ? (unsigned) random() % n : 0;
+}
+
+static unsigned nsizes(const struct conversion *conv) {
+    unsigned n = 0;
+    while (conv->sizes[n])
+        n++;
+    return n;
+}
+
+static void candidate_random(const struct conversion *conv, struct candidate *c) {
+    c->flags = rnd(1U << (sizeof(flagchars) - 1));
+    c->width = (int) rnd((unsigned) opts.max_width + 2) - 1;
+    c->precision = (int) rnd((unsigned) opts.max_precision + 2) - 1;
+    c->size = rnd(nsizes(conv));
+    c->ival = ((uint64_t) random() << 33) ^ ((uint64_t) random() << 2) ^ (uint64_t) random();
+    c->ival >>= rnd(64);
+    c->dval = (double) (int64_t) c->ival / (double) (1U << rnd(32));
+    c->slen = rnd(sizeof(strbuf));
+}
+
+static int clampi(int v, int lo, int hi) {
+    if (v < lo)
+        return lo;
+    if (v > hi)
+        return hi;
+    return v;
+}
+
+static void candidate_mutate(const struct conversion *conv, struct candidate *c) {
+    switch (rnd(6)) {
+        case 0:
+            c->flags ^= 1U << rnd(sizeof(flagchars) - 1);
+            break;
+        case 1:
+            c->width = clampi(c->width + (int) rnd(9) - 4, -1, opts.max_width);
+            break;
+        case 2:
+            c->precision = clampi(c->precision + (int) rnd(9) - 4, -1, opts.max_precision);
+            break;
+        case 3:
+            c->size = rnd(nsizes(conv));
+            break;
+        case 4:
+            c->ival ^= (uint64_t) 1 << rnd(64);
+            c->dval *= (rnd(2) ? 10.0 : 0.1);
+            break;
+        case 5:
+            c->slen = (unsigned) clampi((int) c->slen + (int) rnd(65) - 32, 0, (int) sizeof(strbuf) - 1);
+            break;
+    }
+}
+
+static void candidate_format(const struct conversion *conv, const struct candidate *c,
+                             char *fmt, size_t fmtsize) {
+    size_t n = 0;
+    fmt[n++] = '%';
+    for (unsigned i = 0; i < sizeof(flagchars) - 1; i++)
+        if (c->flags & (1U << i))
+            fmt[n++] = flagchars[i];
+    if (c->width >= 0)
+        n += (size_t) snprintf(&fmt[n], fmtsize - n, "%d", c->width);
+    if (c->precision >= 0)
+        n += (size_t) snprintf(&fmt[n], fmtsize - n, ".%d", c->precision);
+    snprintf(&fmt[n], fmtsize - n, "%s%c", conv->sizes[c->size], conv->specifier);
+}
+
+// timing /////////////////////////////////////////////////////////////////////
+
+static size_t render(const struct conversion *conv, const struct candidate *c, const char *fmt) {
+    size_t nbytes = 0;
+    const char *size = conv->sizes[c->size];
+    switch (conv->type) {
+        case ARG_INT:
+            if (!strcmp(size, "ll") || !strcmp(size, "j"))
+                fmt_fctprintf(bench_discard, &nbytes, fmt, (long long) c->ival);
+            else if (!strcmp(size, "l") || !strcmp(size, "z") || !strcmp(size, "t"))
+                fmt_fctprintf(bench_discard, &nbytes, fmt, (long) c->ival);
+            else
+                fmt_fctprintf(bench_discard, &nbytes, fmt, (int) c->ival);
+            break;
+        case ARG_DOUBLE:
+            fmt_fctprintf(bench_discard, &nbytes, fmt, c->dval);
+            break;
+        case ARG_STR:
+            strbuf[c->slen] = '\0';
+            fmt_fctprintf(bench_discard, &nbytes, fmt, strbuf);
+            strbuf[c->slen] = 'x';
+            break;
+        case ARG_PTR:
+            fmt_fctprintf(bench_discard, &nbytes, fmt, (void *) (uintptr_t) c->ival);
+            break;
+        case ARG_NONE:
+            fmt_fctprintf(bench_discard, &nbytes, fmt);
+            break;
+    }
+    return nbytes;
+}
+
+struct score {
+    uint64_t ns;
+    size_t nbytes;
+};
+
+// Higher is slower.  Normalize by the output length (plus a constant,
+// so that short outputs are not overly favored), as otherwise the
+// search just finds the maximum width.
+static double score_value(struct score s) {
+    return (double) s.ns / (double) (s.nbytes + 16);
+}
+
+static struct score measure(const struct conversion *conv, const struct candidate *c) {
+    char fmt[64];
+    candidate_format(conv, c, fmt, sizeof(fmt));
+    struct score s = {0};
+    s.ns = bench_min_ns(WCET_REPS, s.nbytes = render(conv, c, fmt));
+    return s;
+}
+
+// main ///////////////////////////////////////////////////////////////////////
+
+static void search(const struct conversion *conv) {
+    struct candidate best;
+    struct score best_score = {0};
+    bool have_best = false;
+
+    for (unsigned r = 0; r < opts.restarts; r++) {
+        struct candidate cur;
+        candidate_random(conv, &cur);
+        struct score cur_score = measure(conv, &cur);
+        for (unsigned s = 0; s < opts.steps; s++) {
+            struct candidate next = cur;
+            candidate_mutate(conv, &next);
+            struct score next_score = measure(conv, &next);
+            if (score_value(next_score) > score_value(cur_score)) {
+                cur = next;
+                cur_score = next_score;
+            }
+        }
+        if (!have_best || score_value(cur_score) > score_value(best_score)) {
+            best = cur;
+            best_score = cur_score;
+            have_best = true;
+        }
+    }
+
+    char fmt[64];
+    candidate_format(conv, &best, fmt, sizeof(fmt));
+    printf("%%%c\t%-16s", conv->specifier, fmt);
+    switch (conv->type) {
+        case ARG_INT:
+        case ARG_PTR:
+            printf("\targ=%#-18llx", (unsigned long long) best.ival);
+            break;
+        case ARG_DOUBLE:
+            printf("\targ=%-18g", best.dval);
+            break;
+        case ARG_STR:
+            printf("\tstrlen=%-15u", best.slen);
+            break;
+        case ARG_NONE:
+            printf("\t%-22s", "");
+            break;
+    }
+    printf("\t%6llu ns\t%6zu bytes\t%8.2f ns/byte\n",
+           (unsigned long long) best_score.ns, best_score.nbytes,
+           (double) best_score.ns / (double) (best_score.nbytes ? best_score.nbytes : 1));
+}
+
+static void usage(const char *arg0) {
+    fprintf(stderr, "Usage: %s [-S seed] [-r restarts] [-s steps] [-w max_width] [-p max_precision]\n", arg0);
+    exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "S:r:s:w:p:")) != -1) {
+        switch (opt) {
+            case 'S':
+                opts.seed = (unsigned) strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                opts.restarts = (unsigned) strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                opts.steps = (unsigned) strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                opts.max_width = clampi(atoi(optarg), 0, INT_MAX - 1);
+                break;
+            case 'p':
+                opts.max_precision = clampi(atoi(optarg), 0, INT_MAX - 1);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind != argc)
+        usage(argv[0]);
+
+    srandom(opts.seed);
+    memset(strbuf, 'x', sizeof(strbuf));
+
+    printf("conv\tslowest input\t\targument\t\ttime\t\tlength\t\tcost\n");
+    for (size_t i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++)
+        search(&conversions[i]);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pico/fmt_cksum.h"
+
+// The CRCs are both reflected (LSB-first), and table-driven a nibble
+// at a time; 16-entry tables are a fraction of the ROM of the usual
+// 256-entry ones, for twice the (cheap) table lookups.
+
+// CRC-16/X-25: poly=0x1021 (reflected: 0x8408), init=0xFFFF, xorout=0xFFFF
+static const uint16_t _crc16_nibble[16] = {
+    0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
+    0x8408, 0x9489, 0xA50A, 0xB58B, 0xC60C, 0xD68D, 0xE70E, 0xF78F,
+};
+
+// CRC-32/ISO-HDLC: poly=0x04C11DB7 (reflected: 0xEDB88320), init=0xFFFFFFFF, xorout=0xFFFFFFFF
+static const uint32_t _crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static uint32_t _cksum_init(enum fmt_cksum_kind kind) {
+    switch (kind) {
+        case FMT_CKSUM_XOR8:
+            return 0;
+        case FMT_CKSUM_CRC16:
+            return 0xFFFF;
+        case FMT_CKSUM_CRC32:
+            return 0xFFFFFFFF;
+    }
+    __builtin_unreachable();
+}
+
+void fmt_cksum_init(struct fmt_cksum *ck, enum fmt_cksum_kind kind, fmt_write_t write, void *write_arg) {
+    ck->write = write;
+    ck->write_arg = write_arg;
+    ck->kind = kind;
+    ck->state = _cksum_init(kind);
+}
+
+void fmt_cksum_write(const char *buf, size_t len, void *arg) {
+    struct fmt_cksum *ck = arg;
+    const unsigned char *p = (const unsigned char *) buf;
+    uint32_t c = ck->state;
+    switch (ck->kind) {
+        case FMT_CKSUM_XOR8:
+            for (size_t i = 0; i < len; i++)
+                c ^= p[i];
+            break;
+        case FMT_CKSUM_CRC16:
+            for (size_t i = 0; i < len; i++) {
+                c = (c >> 4) ^ _crc16_nibble[(c ^ p[i]) & 0xF];
+                c = (c >> 4) ^ _crc16_nibble[(c ^ (p[i] >> 4)) & 0xF];
+            }
+            break;
+        case FMT_CKSUM_CRC32:
+            for (size_t i = 0; i < len; i++) {
+                c = (c >> 4) ^ _crc32_nibble[(c ^ p[i]) & 0xF];
+                c = (c >> 4) ^ _crc32_nibble[(c ^ (p[i] >> 4)) & 0xF];
+            }
+            break;
+    }
+    ck->state = c;
+    if (ck->write)
+        ck->write(buf, len, ck->write_arg);
+}
+
+int fmt_cksum_vprintf(struct fmt_cksum *ck, const char *format, va_list va) {
+    return fmt_vwriteprintf(fmt_cksum_write, ck, format, va);
+}
+
+int fmt_cksum_printf(struct fmt_cksum *ck, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_cksum_vprintf(ck, format, va);
+    va_end(va);
+    return ret;
+}
+
+uint32_t fmt_cksum_value(const struct fmt_cksum *ck) {
+    switch (ck->kind) {
+        case FMT_CKSUM_XOR8:
+            return ck->state;
+        case FMT_CKSUM_CRC16:
+            return ck->state ^ 0xFFFF;
+        case FMT_CKSUM_CRC32:
+            return ck->state ^ 0xFFFFFFFF;
+    }
+    __builtin_unreachable();
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+int fmt_cksum_end(struct fmt_cksum *ck, const char *format) {
+    const int ret = fmt_writeprintf(ck->write, ck->write_arg, format, (unsigned int) fmt_cksum_value(ck));
+    ck->state = _cksum_init(ck->kind);
+    return ret;
+}
+#pragma GCC diagnostic pop
@@ -7,6 +7,8 @@
 // Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <string.h> /* for memcpy() */
+
 #include "pico/fmt_install.h"
 #include "pico/fmt_printf.h"
 
@@ -18,11 +20,12 @@ typedef struct {
     size_t cur;
 } _arg_buffer;
 
-static void _out_buffer(char character, void *_arg) {
+static void _write_buffer(const char *buf, size_t len, void *_arg) {
     _arg_buffer *arg = _arg;
-    if (arg->cur < arg->maxlen) {
-        arg->buffer[arg->cur++] = character;
-    }
+    if (len > arg->maxlen - arg->cur)
+        len = arg->maxlen - arg->cur;
+    memcpy(&arg->buffer[arg->cur], buf, len);
+    arg->cur += len;
 }
 
 // va_list wrappers ////////////////////////////////////////////////////////////
@@ -33,7 +36,7 @@ int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list va) {
         .maxlen = count,
         .cur = 0,
     };
-    const int ret = fmt_vfctprintf(buffer && count ? _out_buffer : NULL, &arg, format, va);
+    const int ret = fmt_vwriteprintf(buffer && count ? _write_buffer : NULL, &arg, format, va);
     if (buffer && count)
         buffer[arg.cur < count ? arg.cur : count - 1] = '\0'; // nul-terminate
     return ret;
@@ -53,6 +56,24 @@ int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...) {
     return ret;
 }
 
+int fmt_writeprintf(fmt_write_t out, void *arg, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vwriteprintf(out, arg, format, va);
+    va_end(va);
+    return ret;
+}
+
+#if PICO_PRINTF_SUPPORT_BRACES
+int fmt_writeformat(fmt_write_t out, void *arg, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vwriteformat(out, arg, format, va);
+    va_end(va);
+    return ret;
+}
+#endif
+
 int fmt_snprintf(char *buffer, size_t count, const char *format, ...) {
     va_list va;
     va_start(va, format);
@@ -69,6 +90,14 @@ int fmt_sprintf(char *buffer, const char *format, ...) {
     return ret;
 }
 
+size_t fmt_windowprintf(char *buf, size_t offset, size_t len, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const size_t ret = fmt_vwindowprintf(buf, offset, len, format, va);
+    va_end(va);
+    return ret;
+}
+
 void fmt_state_printf(struct fmt_state *state, const char *format, ...) {
     va_list va;
     va_start(va, format);
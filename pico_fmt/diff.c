@@ -0,0 +1,94 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdint.h> /* for uint32_t, uintptr_t */
+
+#include "pico/fmt_diff.h"
+
+typedef uint32_t _fmt_diff_word __attribute__((may_alias));
+
+#define _is_aligned(p) ((uintptr_t) (p) % sizeof(_fmt_diff_word) == 0)
+
+// \return How many of the `len` bytes at `a` and `b` are the same before
+// the first one that isn't; a word at a time once they are aligned.
+static size_t _same(const char *a, const char *b, size_t len) {
+    size_t i = 0;
+    while (i < len && !_is_aligned(&a[i]) && a[i] == b[i]) // unaligned head
+        i++;
+    if (_is_aligned(&a[i]) && _is_aligned(&b[i]))
+        while (len - i >= sizeof(_fmt_diff_word) && // aligned words
+               *(const _fmt_diff_word *) &a[i] == *(const _fmt_diff_word *) &b[i])
+            i += sizeof(_fmt_diff_word);
+    while (i < len && a[i] == b[i]) // tail
+        i++;
+    return i;
+}
+
+void fmt_diff_init(struct fmt_diff *d, char *shadow, size_t size, fmt_diff_fn_t fn, void *fn_arg) {
+    for (size_t i = 0; i < size; i++)
+        shadow[i] = '\0';
+    d->shadow = shadow;
+    d->size = size;
+    d->fn = fn;
+    d->fn_arg = fn_arg;
+    d->pos = 0;
+    d->in_run = false;
+    d->run_start = 0;
+    d->changed = 0;
+}
+
+static void _end_run(struct fmt_diff *d) {
+    if (!d->in_run)
+        return;
+    d->fn(d->run_start, &d->shadow[d->run_start], d->pos - d->run_start, d->fn_arg);
+    d->in_run = false;
+}
+
+void fmt_diff_write(const char *buf, size_t len, void *arg) {
+    struct fmt_diff *d = arg;
+    if (len > d->size - d->pos)
+        len = d->size - d->pos;
+    while (len) {
+        // skip over what is the same
+        const size_t same = _same(buf, &d->shadow[d->pos], len);
+        if (same) {
+            _end_run(d);
+            buf += same;
+            d->pos += same;
+            len -= same;
+        }
+        // copy in what is different
+        if (len && !d->in_run) {
+            d->in_run = true;
+            d->run_start = d->pos;
+        }
+        while (len && *buf != d->shadow[d->pos]) {
+            d->shadow[d->pos++] = *buf++;
+            d->changed++;
+            len--;
+        }
+    }
+}
+
+int fmt_diff_vprintf(struct fmt_diff *d, const char *format, va_list va) {
+    return fmt_vwriteprintf(fmt_diff_write, d, format, va);
+}
+
+int fmt_diff_printf(struct fmt_diff *d, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_diff_vprintf(d, format, va);
+    va_end(va);
+    return ret;
+}
+
+size_t fmt_diff_end(struct fmt_diff *d) {
+    static const char spaces[16] = "                ";
+    while (d->pos < d->size)
+        fmt_diff_write(spaces, sizeof(spaces), d);
+    _end_run(d);
+    const size_t changed = d->changed;
+    d->pos = 0;
+    d->changed = 0;
+    return changed;
+}
@@ -0,0 +1,655 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_HPP
+#define _PICO_FMT_HPP
+
+#include <cstddef>     /* for std::size_t, std::ptrdiff_t, std::nullptr_t */
+#include <cstdint>     /* for std::intmax_t */
+#include <type_traits> /* for std::decay_t, std::is_*_v */
+#include <utility>     /* for std::declval */
+
+#include "pico/fmt_install.h" /* for struct fmt_state, fmt_state_convert() */
+#include "pico/fmt_printf.h"
+
+/** \file fmt.hpp
+ *
+ * \brief A type-checked C++20 front end
+ *
+ * fmt::print_to() takes the same format strings as fmt_printf(), but
+ * checks them against the types of the arguments at compile time, and
+ * hands the arguments to the engine as an array of `struct fmt_arg`
+ * rather than marshalling them through a va_list:
+ *
+ *     auto uart = [](const char *buf, size_t len) { uart_write_blocking(uart0, buf, len); };
+ *     fmt::print_to(uart, "%s: %5.1f%%\n", name, pct);
+ *
+ * The sink may be anything that is callable as `sink(buf, len)`.
+ *
+ * The checking follows the same rules as `-Wformat`, except that an
+ * integer argument matches an integer conversion if it is the same
+ * size after promotion (so `%u` takes a `uint32_t` whether that is an
+ * `unsigned int` or an `unsigned long`), and that a mismatch is an
+ * error rather than a warning.  The error is a call to a function in
+ * `fmt::detail` whose name says what is wrong, such as
+ * `fmt::detail::argument_type_does_not_match_conversion()`.
+ *
+ * fmt::format_to() is the same, but with the std::format-style `{}`
+ * syntax of fmt_vwriteformat():
+ *
+ *     fmt::format_to(uart, "{}: {:>5.1f}%\n", name, pct);
+ *
+ * A type of your own is made printable by specializing fmt::formatter
+ * for it; it is then printed by `%v` (and by `{}`).
+ *
+ * It uses neither exceptions nor RTTI.
+ */
+
+namespace fmt {
+
+/**
+ * \brief Specialize this to make `T` printable with `%v` (and `{}`)
+ *
+ * A specialization has a static `format()` member, which is given the
+ * state of the `%v` conversion (its flags, width, and precision) and
+ * the value; it may output with fmt_state_putchar(), fmt_state_write(),
+ * and fmt::convert():
+ *
+ *     template <>
+ *     struct fmt::formatter<q16_16> {
+ *         static void format(fmt_state *state, const q16_16 &v) {
+ *             fmt::convert<'d'>(state, v.raw >> 16);
+ *             fmt_state_putchar(state, '.');
+ *             ...
+ *         }
+ *     };
+ *
+ *     fmt::print_to(uart, "temp=%v\n", reading);
+ *
+ * The call is resolved at compile time: the argument is passed to the
+ * engine as a pointer to the value and a pointer to
+ * `formatter<T>::format()`, which `%v` calls directly.  A formatter
+ * takes precedence over the built-in handling of the type, so an enum
+ * with a formatter is printed by it rather than as an integer.
+ *
+ * Only available if pico-fmt is built with PICO_PRINTF_SUPPORT_VALUE.
+ */
+template <typename T>
+struct formatter {};
+
+namespace detail {
+
+template <typename T>
+concept has_formatter = requires(fmt_state *state, const T &v) { formatter<T>::format(state, v); };
+
+// What the format string needs to know about the type of an argument.
+enum arg_type {
+    ARG_INVALID,   // can't be formatted
+    ARG_INT,       // an integer, enum, or bool that promotes to `int` (or `unsigned int`)
+    ARG_LONG,      // `long` or `unsigned long`
+    ARG_LONG_LONG, // `long long` or `unsigned long long`
+    ARG_DOUBLE,    // `float` or `double`
+    ARG_STR,       // a pointer to `char`
+    ARG_PTR,       // any other object pointer
+    ARG_NULL,      // `nullptr`
+    ARG_VALUE,     // a type with a fmt::formatter
+};
+
+template <typename T>
+constexpr arg_type type_of() {
+    if constexpr (has_formatter<T>)
+        return ARG_VALUE;
+    else if constexpr (std::is_same_v<T, std::nullptr_t>)
+        return ARG_NULL;
+    else if constexpr (std::is_pointer_v<T> && !std::is_function_v<std::remove_pointer_t<T>>) {
+        using U = std::remove_cv_t<std::remove_pointer_t<T>>;
+        if constexpr (std::is_same_v<U, char> || std::is_same_v<U, signed char> || std::is_same_v<U, unsigned char>)
+            return ARG_STR;
+        else
+            return ARG_PTR;
+    } else if constexpr (std::is_integral_v<T> || (std::is_enum_v<T> && std::is_convertible_v<T, int>)) {
+        if constexpr (sizeof(T) <= sizeof(int))
+            return ARG_INT;
+        else if constexpr (sizeof(T) == sizeof(long))
+            return ARG_LONG;
+        else
+            return ARG_LONG_LONG;
+    } else if constexpr (std::is_floating_point_v<T> && sizeof(T) <= sizeof(double))
+        return ARG_DOUBLE;
+    else
+        return ARG_INVALID;
+}
+
+constexpr std::size_t int_size(arg_type t) {
+    switch (t) {
+        case ARG_INT:
+            return sizeof(int);
+        case ARG_LONG:
+            return sizeof(long);
+        case ARG_LONG_LONG:
+            return sizeof(long long);
+        case ARG_INVALID:
+        case ARG_DOUBLE:
+        case ARG_STR:
+        case ARG_PTR:
+        case ARG_NULL:
+        case ARG_VALUE:
+            return 0;
+    }
+    return 0;
+}
+
+// Whether an argument of type `have` may be read by a conversion that wants `want`.
+constexpr bool compatible(arg_type want, arg_type have) {
+    switch (want) {
+        case ARG_PTR:
+            return have == ARG_PTR || have == ARG_STR || have == ARG_NULL;
+        case ARG_STR:
+            return have == ARG_STR;
+        case ARG_DOUBLE:
+            return have == ARG_DOUBLE;
+        case ARG_VALUE:
+            return have == ARG_VALUE;
+        case ARG_INT:
+        case ARG_LONG:
+        case ARG_LONG_LONG:
+            return int_size(have) == int_size(want);
+        case ARG_INVALID:
+        case ARG_NULL:
+            return false;
+    }
+    return false;
+}
+
+// These are deliberately not constexpr: calling one while checking the
+// format string stops the compile, with its name in the error message.
+inline void too_few_arguments() {}
+inline void too_many_arguments() {}
+inline void argument_type_does_not_match_conversion() {}
+inline void argument_type_cannot_be_formatted() {}
+inline void unknown_conversion() {}
+inline void incomplete_conversion() {}
+inline void unmatched_close_brace() {}
+inline void bad_replacement_field() {}
+inline void argument_numbers_not_supported() {}
+inline void fill_not_supported() {}
+inline void center_align_not_supported() {}
+inline void dynamic_width_or_precision_not_supported() {}
+
+constexpr bool is_digit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+// The arguments, and how far through them the format string has read.
+template <typename... Args>
+struct arg_reader {
+    static constexpr arg_type types[] = {type_of<Args>()..., ARG_INVALID};
+    static constexpr std::size_t nargs = sizeof...(Args);
+    std::size_t n = 0;
+
+    constexpr void take(arg_type want) {
+        if (n == nargs)
+            too_few_arguments();
+        if (types[n] == ARG_INVALID)
+            argument_type_cannot_be_formatted();
+        if (!compatible(want, types[n]))
+            argument_type_does_not_match_conversion();
+        n++;
+    }
+
+    // Take the arguments of the conversion `spec`, with integers of
+    // the type `integer`; or return false if there is no such
+    // conversion.
+    constexpr bool take_conversion(char spec, arg_type integer) {
+        switch (spec) {
+            case '%':
+                break;
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'b':
+#if PICO_PRINTF_SUPPORT_UNITS
+            case 'K':
+            case 'T':
+#endif
+                take(integer);
+                break;
+            case 'c':
+                take(ARG_INT);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                take(ARG_DOUBLE);
+                break;
+            case 's':
+#if PICO_PRINTF_SUPPORT_QUOTE
+            case 'q':
+#endif
+                take(ARG_STR);
+                break;
+            case 'p':
+#if PICO_PRINTF_SUPPORT_NETADDR
+            case 'I':
+            case 'M':
+#endif
+                take(ARG_PTR);
+                break;
+#if PICO_PRINTF_SUPPORT_SLICE
+            case 'S':
+                take(ARG_STR);
+                take(type_of<std::size_t>());
+                break;
+#endif
+#if PICO_PRINTF_SUPPORT_HEXDUMP
+            case 'H':
+#endif
+#if PICO_PRINTF_SUPPORT_BASE64
+            case 'r':
+#endif
+#if PICO_PRINTF_SUPPORT_HEXDUMP || PICO_PRINTF_SUPPORT_BASE64
+                take(ARG_PTR);
+                take(type_of<std::size_t>());
+                break;
+#endif
+#if PICO_PRINTF_SUPPORT_STRUCT
+            case 'R':
+                take(ARG_PTR);
+                take(ARG_PTR);
+                break;
+#endif
+#if PICO_PRINTF_SUPPORT_VALUE
+            case 'v':
+                take(ARG_VALUE);
+                break;
+#endif
+            default:
+                return false;
+        }
+        return true;
+    }
+
+    // Take one argument, of any type that can be formatted.
+    constexpr void take_any() {
+        take(n < nargs && types[n] != ARG_NULL ? types[n] : ARG_PTR);
+    }
+
+    constexpr void done() {
+        if (n != nargs)
+            too_many_arguments();
+    }
+};
+
+// Evaluate a printf size field, returning the integer type that it
+// is for, or `dflt` if there isn't one.
+constexpr arg_type parse_size(const char *&p, arg_type dflt) {
+    switch (*p) {
+        case 'l':
+            if (*++p == 'l') {
+                p++;
+                return ARG_LONG_LONG;
+            }
+            return ARG_LONG;
+        case 'h':
+            if (*++p == 'h')
+                p++;
+            return ARG_INT;
+        case 't':
+            p++;
+            return type_of<std::ptrdiff_t>();
+        case 'j':
+            p++;
+            return type_of<std::intmax_t>();
+        case 'z':
+            p++;
+            return type_of<std::size_t>();
+        default:
+            return dflt;
+    }
+}
+
+// Walk the format string the same way that the engine's parser does,
+// checking each argument that a conversion reads against its type.
+template <typename... Args>
+consteval void check(const char *p) {
+    arg_reader<Args...> args;
+
+    while (*p) {
+        if (*p++ != '%')
+            continue;
+
+        // flags
+        while (*p == '0' || *p == '-' || *p == '+' || *p == ' ' || *p == '#')
+            p++;
+
+        // width
+        if (*p == '*') {
+            args.take(ARG_INT);
+            p++;
+        } else {
+            while (is_digit(*p))
+                p++;
+        }
+
+        // precision
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                args.take(ARG_INT);
+                p++;
+            } else {
+                while (is_digit(*p))
+                    p++;
+            }
+        }
+
+        // size
+        const arg_type integer = parse_size(p, ARG_INT);
+
+        // specifier
+        if (!*p) {
+            incomplete_conversion();
+            return;
+        }
+        if (!args.take_conversion(*p++, integer))
+            unknown_conversion();
+    }
+    args.done();
+}
+
+// The same, but for the `{}` syntax of fmt_vwriteformat().
+template <typename... Args>
+consteval void check_braces(const char *p) {
+    arg_reader<Args...> args;
+
+    while (*p) {
+        if (*p != '{' && *p != '}') {
+            p++;
+            continue;
+        }
+        if (p[1] == p[0]) {
+            p += 2;
+            continue;
+        }
+        if (*p++ == '}')
+            unmatched_close_brace();
+        if (is_digit(*p))
+            argument_numbers_not_supported();
+
+        char spec = '\0';
+        bool sized = false;
+        arg_type integer = ARG_INT;
+        if (*p == ':') {
+            p++;
+            // fill and align
+            if (p[1] == '<' || p[1] == '>' || p[1] == '^') {
+                if (*p != ' ')
+                    fill_not_supported();
+                p++;
+            }
+            if (*p == '^')
+                center_align_not_supported();
+            if (*p == '<' || *p == '>')
+                p++;
+            // sign, '#', '0'
+            if (*p == '+' || *p == ' ' || *p == '-')
+                p++;
+            if (*p == '#')
+                p++;
+            if (*p == '0')
+                p++;
+            // width and precision
+            if (*p == '{')
+                dynamic_width_or_precision_not_supported();
+            while (is_digit(*p))
+                p++;
+            if (*p == '.') {
+                p++;
+                if (*p == '{')
+                    dynamic_width_or_precision_not_supported();
+                while (is_digit(*p))
+                    p++;
+            }
+            // size and type
+            const char *size = p;
+            integer = parse_size(p, ARG_INT);
+            sized = p != size;
+            if (*p && *p != '}')
+                spec = *p++;
+        }
+        if (*p++ != '}') {
+            bad_replacement_field();
+            return;
+        }
+
+        if (!sized && args.n < args.nargs && int_size(args.types[args.n]))
+            // the engine sizes it by the argument
+            integer = args.types[args.n];
+        if (!spec)
+            // the engine formats it by the argument's type
+            args.take_any();
+        else if (!args.take_conversion(spec, integer))
+            // An fmt_install() specifier, which could read anything;
+            // assume that it reads one argument.
+            args.take_any();
+    }
+    args.done();
+}
+
+template <typename T>
+constexpr bool always_false = false;
+
+// How many `struct fmt_arg`s an argument takes.
+template <typename T>
+constexpr std::size_t nslots = type_of<T>() == ARG_VALUE ? 2 : 1;
+
+template <typename T>
+void call_formatter(fmt_state *state, const void *obj) {
+    formatter<T>::format(state, *static_cast<const T *>(obj));
+}
+
+template <typename T>
+inline fmt_arg make_arg(const T &v) {
+    fmt_arg a;
+    constexpr arg_type t = type_of<T>();
+    if constexpr (t == ARG_INT)
+        a.i = static_cast<int>(v);
+    else if constexpr (t == ARG_LONG)
+        a.l = static_cast<long>(v);
+    else if constexpr (t == ARG_LONG_LONG)
+        a.ll = static_cast<long long>(v);
+    else if constexpr (t == ARG_DOUBLE)
+        a.d = static_cast<double>(v);
+    else if constexpr (t == ARG_STR || t == ARG_PTR)
+        a.p = static_cast<const void *>(v);
+    else if constexpr (t == ARG_NULL)
+        a.p = nullptr;
+    else
+        static_assert(always_false<T>, "fmt: argument type cannot be formatted");
+    return a;
+}
+
+// Store the argument `v` at `a`, advancing `a` past it.
+template <typename T>
+inline void put_arg(fmt_arg *&a, const T &v) {
+    if constexpr (type_of<T>() == ARG_VALUE) {
+        (a++)->fn = &call_formatter<T>;
+        (a++)->p = static_cast<const void *>(&v);
+    } else {
+        *a++ = make_arg<T>(v);
+    }
+}
+
+// The arguments, as the engine reads them.
+template <typename... Ts>
+struct arg_array {
+    fmt_arg argv[(nslots<Ts> + ... + 0) + 1];
+
+    arg_array(const Ts &...args) : argv{} {
+        fmt_arg *a = argv;
+        (put_arg<Ts>(a, args), ...);
+    }
+};
+
+// The conversion that a `{}` field with no type gives an argument.
+template <typename T>
+constexpr const char *default_type() {
+    constexpr arg_type t = type_of<T>();
+    if constexpr (std::is_same_v<T, char>)
+        return "c";
+    else if constexpr (t == ARG_INT || t == ARG_LONG || t == ARG_LONG_LONG) {
+        constexpr bool sign = std::is_signed_v<decltype(+std::declval<T>())>;
+        if constexpr (t == ARG_INT)
+            return sign ? "d" : "u";
+        else if constexpr (t == ARG_LONG)
+            return sign ? "ld" : "lu";
+        else
+            return sign ? "lld" : "llu";
+    } else if constexpr (t == ARG_VALUE)
+        return "v";
+    else if constexpr (t == ARG_DOUBLE)
+        return "g";
+    else if constexpr (t == ARG_STR)
+        return "s";
+    else
+        return "p";
+}
+
+// default_type() of each argument, indexed by where it starts in
+// its arg_array.
+template <typename... Ts>
+struct type_array {
+    const char *types[(nslots<Ts> + ... + 0) + 1];
+
+    constexpr type_array() : types{} {
+        std::size_t i = 0;
+        ((types[i] = default_type<Ts>(), i += nslots<Ts>), ...);
+    }
+};
+
+template <typename Sink>
+void write(const char *buf, std::size_t len, void *arg) {
+    (*static_cast<Sink *>(arg))(buf, len);
+}
+
+// Call `fn(write, arg)` with a fmt_write_t that calls `sink`.
+template <typename Sink, typename Fn>
+int with_sink(Sink &sink, Fn &&fn) {
+    if constexpr (std::is_same_v<std::remove_cv_t<Sink>, std::nullptr_t>) {
+        return fn(nullptr, nullptr);
+    } else if constexpr (std::is_function_v<Sink>) {
+        Sink *ptr = sink;
+        return fn(&write<Sink *>, static_cast<void *>(&ptr));
+    } else {
+        return fn(&write<Sink>, const_cast<void *>(static_cast<const void *>(&sink)));
+    }
+}
+
+} // namespace detail
+
+/**
+ * \brief A format string that has been checked against the types `Args`
+ *
+ * This is only ever constructed implicitly, from a string literal, at
+ * compile time.
+ */
+template <typename... Args>
+struct format_string {
+    const char *str;
+
+    template <std::size_t N>
+    consteval format_string(const char (&s)[N]) : str(s) {
+        detail::check<Args...>(s);
+    }
+};
+
+/**
+ * \brief printf to a sink, with the arguments checked at compile time
+ *
+ * \param sink Called as `sink(const char *buf, size_t len)` with each run of
+ *     output; or `nullptr` to only count the length (see also <pico/fmt_sinks.hpp>)
+ * \return The number of characters written to the sink
+ */
+template <typename Sink, typename... Args>
+int print_to(Sink &&sink, format_string<std::decay_t<const Args &>...> format, const Args &...args) {
+    const detail::arg_array<std::decay_t<const Args &>...> argv(args...);
+    return detail::with_sink(sink, [&](fmt_write_t write, void *arg) {
+        return fmt_writeprintf_argv(write, arg, format.str, argv.argv);
+    });
+}
+
+/**
+ * \brief Run the conversion `Spec` on `v`, from inside a fmt::formatter
+ *
+ * This outputs `v` by calling the conversion directly, rather than by
+ * parsing a format string with fmt_state_printf().  The conversion
+ * uses the flags, width, and precision in `state` (copy it and set
+ * them to change them); the integer size comes from `v`.  `Spec` is
+ * checked against the type of `v` at compile time.
+ */
+template <char Spec, typename T>
+void convert(fmt_state *state, const T &v) {
+    using D = std::decay_t<const T &>;
+    []() consteval {
+        detail::arg_reader<D> args;
+        if (!args.take_conversion(Spec, detail::int_size(detail::type_of<D>()) ? detail::type_of<D>() : detail::ARG_INT))
+            detail::unknown_conversion();
+        args.done();
+    }();
+    const detail::arg_array<D> argv(v);
+    fmt_state sub = *state;
+    if constexpr (detail::type_of<D>() == detail::ARG_LONG_LONG)
+        sub.size = FMT_SIZE_LONG_LONG;
+    else if constexpr (detail::type_of<D>() == detail::ARG_LONG)
+        sub.size = FMT_SIZE_LONG;
+    else
+        sub.size = FMT_SIZE_DEFAULT;
+    fmt_state_convert(&sub, Spec, argv.argv);
+}
+
+#if PICO_PRINTF_SUPPORT_BRACES
+/**
+ * \brief Like format_string, but for the `{}` syntax
+ */
+template <typename... Args>
+struct brace_format_string {
+    const char *str;
+
+    template <std::size_t N>
+    consteval brace_format_string(const char (&s)[N]) : str(s) {
+        detail::check_braces<Args...>(s);
+    }
+};
+
+/**
+ * \brief Like print_to(), but with std::format-style `{}` fields
+ *
+ * See fmt_vwriteformat() for the syntax.  Here a field may leave out
+ * the type (`{}`, `{:>8}`), which then comes from the argument: `d`
+ * or `u` for integers, `c` for `char`, `g` for floating-point, `s` for
+ * strings, `v` for types with a fmt::formatter, and `p` for other
+ * pointers; and the printf size never needs to be given, as it also
+ * comes from the argument.  Type characters registered with
+ * fmt_install() are assumed to read one argument, of any type.
+ *
+ * Only available if pico-fmt is built with PICO_PRINTF_SUPPORT_BRACES.
+ */
+template <typename Sink, typename... Args>
+int format_to(Sink &&sink, brace_format_string<std::decay_t<const Args &>...> format, const Args &...args) {
+    static constexpr detail::type_array<std::decay_t<const Args &>...> types;
+    const detail::arg_array<std::decay_t<const Args &>...> argv(args...);
+    return detail::with_sink(sink, [&](fmt_write_t write, void *arg) {
+        return fmt_writeformat_argv(write, arg, format.str, argv.argv, types.types);
+    });
+}
+#endif
+
+} // namespace fmt
+
+#endif
@@ -0,0 +1,86 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_CKSUM_H
+#define _PICO_FMT_CKSUM_H
+
+#include <stdint.h> /* for uint32_t */
+
+#include "pico/fmt_printf.h"
+
+/** \file fmt_cksum.h
+ *
+ * \brief An output adapter that checksums the output as it is written
+ *
+ * A `struct fmt_cksum` sits between the formatter and another bulk
+ * output function, keeping a running checksum of every byte that
+ * passes through it; so formatting a record and checksumming it is a
+ * single pass.  For example, an NMEA 0183 sentence (whose checksum is
+ * the XOR of everything between the '$' and the '*'):
+ *
+ *     struct fmt_cksum ck;
+ *     fmt_cksum_init(&ck, FMT_CKSUM_XOR8, uart_write, uart);
+ *     uart_write("$", 1, uart);
+ *     fmt_cksum_printf(&ck, "GPGLL,%s,%c,%s,%c", lat, ns, lon, ew);
+ *     fmt_cksum_end(&ck, "*%02X\r\n");
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum fmt_cksum_kind {
+    FMT_CKSUM_XOR8,  // XOR of all bytes, as in NMEA 0183
+    FMT_CKSUM_CRC16, // CRC-16/X-25, the HDLC and PPP FCS-16
+    FMT_CKSUM_CRC32, // CRC-32/ISO-HDLC, as in zlib, Ethernet, and PNG
+};
+
+struct fmt_cksum {
+    // private
+    fmt_write_t write;
+    void *write_arg;
+    enum fmt_cksum_kind kind;
+    uint32_t state;
+};
+
+/**
+ * \brief Set up `ck` to checksum output that it passes on to `write`
+ *
+ * \param write The output function to pass the output on to; or NULL to only checksum it
+ * \param write_arg The argument pointer to pass to `write`
+ */
+void fmt_cksum_init(struct fmt_cksum *ck, enum fmt_cksum_kind kind, fmt_write_t write, void *write_arg);
+
+/**
+ * \brief A bulk output function (fmt_write_t) that checksums its input
+ *
+ * `arg` must be a `struct fmt_cksum *`.  This may be passed to
+ * fmt_writeprintf() or fmt_vwriteprintf() directly; fmt_cksum_printf()
+ * is a shorthand for that.
+ */
+void fmt_cksum_write(const char *buf, size_t len, void *arg);
+
+int fmt_cksum_vprintf(struct fmt_cksum *ck, const char *format, va_list va) [[gnu::format(printf, 2, 0)]];
+int fmt_cksum_printf(struct fmt_cksum *ck, const char *format, ...) [[gnu::format(printf, 2, 3)]];
+
+/**
+ * \brief The checksum of everything written since init (or the last end)
+ */
+uint32_t fmt_cksum_value(const struct fmt_cksum *ck);
+
+/**
+ * \brief End the record: write the checksum, and start a new one
+ *
+ * Writes the checksum to the underlying output function (without
+ * checksumming it), formatted by `format`, which must consume exactly
+ * one `unsigned int` (such as "*%02X\r\n"); then resets the checksum.
+ *
+ * \return The number of characters written
+ */
+int fmt_cksum_end(struct fmt_cksum *ck, const char *format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_DIFF_H
+#define _PICO_FMT_DIFF_H
+
+#include <stdbool.h> /* for bool */
+
+#include "pico/fmt_printf.h"
+
+/** \file fmt_diff.h
+ *
+ * \brief An output adapter that sends only what changed since the last frame
+ *
+ * A `struct fmt_diff` keeps a shadow copy of a fixed-size frame (such
+ * as the 80 characters of a 20x4 character LCD), and compares each
+ * frame's output against it as the output is written, passing only
+ * the runs of characters that changed on to an output function; so a
+ * status screen can be re-formatted in full every refresh while only
+ * the changed glyphs go over the (slow) link to the display:
+ *
+ *     static char shadow[20 * 4];
+ *     struct fmt_diff d;
+ *     fmt_diff_init(&d, shadow, sizeof(shadow), lcd_put_at, lcd);
+ *     for (;;) {
+ *         fmt_diff_printf(&d, "%-20.20s", title);
+ *         fmt_diff_printf(&d, "T=%5.1fC  RH=%3d%%   ", temp, rh);
+ *         ...
+ *         fmt_diff_end(&d);
+ *         sleep_ms(100);
+ *     }
+ *
+ * The comparison is a word at a time where the output and the shadow
+ * are both word-aligned, and the shadow is updated in the same pass.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Called with each run of changed characters
+ *
+ * \param offset Where in the frame the run starts
+ * \param buf The new characters (which point in to the shadow buffer)
+ * \param len How many characters there are in the run
+ */
+typedef void (*fmt_diff_fn_t)(size_t offset, const char *buf, size_t len, void *arg);
+
+struct fmt_diff {
+    // private
+    char *shadow;
+    size_t size;
+    fmt_diff_fn_t fn;
+    void *fn_arg;
+    size_t pos;       // where in the frame the next character goes
+    bool in_run;      // whether the characters before pos changed
+    size_t run_start; // if in_run, where that run of changed characters starts
+    size_t changed;   // how many characters of this frame have changed
+};
+
+/**
+ * \brief Set up `d` to diff frames of `size` characters against `shadow`
+ *
+ * `shadow` is cleared to NUL bytes, so that all of the first frame
+ * is sent (unless it has NUL bytes in it).  To start from a known
+ * display content instead, fill `shadow` with that after this.
+ *
+ * \param fn The function to pass the runs of changed characters to
+ * \param fn_arg The argument pointer to pass to `fn`
+ */
+void fmt_diff_init(struct fmt_diff *d, char *shadow, size_t size, fmt_diff_fn_t fn, void *fn_arg);
+
+/**
+ * \brief A bulk output function (fmt_write_t) that diffs its input against the frame
+ *
+ * `arg` must be a `struct fmt_diff *`.  The output is appended to the
+ * frame; whatever goes past the end of the frame is dropped.
+ */
+void fmt_diff_write(const char *buf, size_t len, void *arg);
+
+int fmt_diff_vprintf(struct fmt_diff *d, const char *format, va_list va) [[gnu::format(printf, 2, 0)]];
+int fmt_diff_printf(struct fmt_diff *d, const char *format, ...) [[gnu::format(printf, 2, 3)]];
+
+/**
+ * \brief End the frame, and start the next one
+ *
+ * If the frame is short, the rest of it is filled with spaces (as if
+ * it had been printed).  Then the last run of changed characters (if
+ * any) is passed on.
+ *
+ * \return How many characters of the frame changed
+ */
+size_t fmt_diff_end(struct fmt_diff *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -44,6 +44,7 @@ struct fmt_state {
     char specifier;
 
     va_list *args;
+    const struct fmt_arg *argv; // if non-NULL, read arguments from here instead of args
 
     struct _fmt_ctx *ctx;
 };
@@ -59,11 +60,58 @@ typedef void (*fmt_specifier_t)(struct fmt_state *);
 
 // Utilities for implementing the specifier ////////////////////////////////////
 
+// Read the next argument.  Use these rather than va_arg(*state->args,
+// ...), so that your specifier also works when called with typed
+// arguments (fmt_writeprintf_argv(), or <pico/fmt.hpp>).
+static inline int fmt_state_arg_int(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->i : va_arg(*state->args, int);
+}
+static inline unsigned int fmt_state_arg_uint(struct fmt_state *state) {
+    return state->argv ? (unsigned int) (state->argv++)->i : va_arg(*state->args, unsigned int);
+}
+static inline long fmt_state_arg_long(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->l : va_arg(*state->args, long);
+}
+static inline unsigned long fmt_state_arg_ulong(struct fmt_state *state) {
+    return state->argv ? (unsigned long) (state->argv++)->l : va_arg(*state->args, unsigned long);
+}
+static inline long long fmt_state_arg_llong(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->ll : va_arg(*state->args, long long);
+}
+static inline unsigned long long fmt_state_arg_ullong(struct fmt_state *state) {
+    return state->argv ? (unsigned long long) (state->argv++)->ll : va_arg(*state->args, unsigned long long);
+}
+static inline size_t fmt_state_arg_size(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->z : va_arg(*state->args, size_t);
+}
+static inline double fmt_state_arg_double(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->d : va_arg(*state->args, double);
+}
+static inline const void *fmt_state_arg_ptr(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->p : va_arg(*state->args, const void *);
+}
+static inline fmt_value_fn_t fmt_state_arg_fn(struct fmt_state *state) {
+    return state->argv ? (state->argv++)->fn : va_arg(*state->args, fmt_value_fn_t);
+}
+
 void fmt_state_putchar(struct fmt_state *state, char character);
 void fmt_state_puts(struct fmt_state *state, const char *str); // no trailing newline
+void fmt_state_write(struct fmt_state *state, const char *buf, size_t len);
 void fmt_state_vprintf(struct fmt_state *state, const char *format, va_list va) [[gnu::format(printf, 2, 0)]];
 void fmt_state_printf(struct fmt_state *state, const char *format, ...) [[gnu::format(printf, 2, 3)]];
 
+/**
+ * \brief Run the conversion `specifier` on the arguments in `argv`.
+ *
+ * This is for a specifier (or a fmt_value_fn_t) to output a number
+ * or string without going through fmt_state_printf(), and so without
+ * parsing a format string.  The conversion uses the flags, width,
+ * precision, and size in `state` (set them first to change them;
+ * `state` is not modified), and reads its arguments from `argv`
+ * (which must not be NULL) rather than from the caller's arguments.
+ */
+void fmt_state_convert(struct fmt_state *state, char specifier, const struct fmt_arg *argv);
+
 /**
  * \brief How many characters have been fmt_state_putchar()ed so far.
  *
@@ -0,0 +1,108 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_IOVEC_H
+#define _PICO_FMT_IOVEC_H
+
+#include <stdbool.h> /* for bool */
+
+#include "pico/fmt_printf.h"
+
+/** \file fmt_iovec.h
+ *
+ * \brief An output adapter that builds a scatter/gather list
+ *
+ * A `struct fmt_iovec` turns the output in to a list of (pointer,
+ * length) entries, for writev() or a DMA descriptor chain, without
+ * copying what doesn't need to be copied: runs of literal text and
+ * the bodies of `%s` and `%S` arguments are referred to where they
+ * are, and only the generated characters (numbers, padding, and the
+ * like) are copied, in to a small scratch buffer.  So a 2 KiB `%s`
+ * costs one entry, rather than a 2 KiB copy:
+ *
+ *     struct fmt_iov iov[8];
+ *     char scratch[64];
+ *     struct fmt_iovec v;
+ *     fmt_iovec_init(&v, iov, 8, scratch, sizeof(scratch));
+ *     fmt_iovec_printf(&v, "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n%s", len, body);
+ *     dma_send_chain(iov, fmt_iovec_count(&v));
+ *
+ * Everything that the entries point at (the format string, the
+ * arguments, and the scratch buffer) must stay valid until the list
+ * has been sent.  Entries that are next to each other in memory are
+ * merged, and a run that is shorter than an entry is copied rather
+ * than referred to.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief One entry in the list; laid out the same as POSIX `struct iovec`
+ */
+struct fmt_iov {
+    const char *base;
+    size_t len;
+};
+
+struct fmt_iovec {
+    // private
+    struct fmt_iov *iov;
+    size_t iov_max;
+    size_t iov_cnt;
+    char *scratch;
+    size_t scratch_size;
+    size_t scratch_len; // how much of scratch is in use
+    bool truncated;     // whether output has been dropped
+};
+
+/**
+ * \brief Set up `v` to build a list of up to `iov_max` entries at `iov`
+ *
+ * This is also how to start a new list once the old one has been sent.
+ *
+ * \param scratch Where to copy generated characters to
+ * \param scratch_size How big `scratch` is
+ */
+void fmt_iovec_init(struct fmt_iovec *v, struct fmt_iov *iov, size_t iov_max, char *scratch, size_t scratch_size);
+
+/**
+ * \brief A bulk output function (fmt_write_t) that copies its input in to the list
+ *
+ * `arg` must be a `struct fmt_iovec *`.
+ */
+void fmt_iovec_write(const char *buf, size_t len, void *arg);
+
+/**
+ * \brief A bulk output function (fmt_write_t) that refers to its input from the list
+ *
+ * `arg` must be a `struct fmt_iovec *`.  `buf` must stay valid until
+ * the list has been sent.  This is the `ref` for
+ * fmt_vwriterefprintf(), and may also be called directly, to add a
+ * buffer (such as a packet header) to the list.
+ */
+void fmt_iovec_ref(const char *buf, size_t len, void *arg);
+
+int fmt_iovec_vprintf(struct fmt_iovec *v, const char *format, va_list va) [[gnu::format(printf, 2, 0)]];
+int fmt_iovec_printf(struct fmt_iovec *v, const char *format, ...) [[gnu::format(printf, 2, 3)]];
+
+/**
+ * \brief How many entries of the list are in use
+ */
+size_t fmt_iovec_count(const struct fmt_iovec *v);
+
+/**
+ * \brief Whether output has been dropped since init
+ *
+ * Once either the entries or the scratch buffer run out, the rest of
+ * the output is dropped (rather than leaving a gap in the list); the
+ * printf functions still return the full length.
+ */
+bool fmt_iovec_truncated(const struct fmt_iovec *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
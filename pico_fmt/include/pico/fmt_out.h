@@ -0,0 +1,76 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_OUT_H
+#define _PICO_FMT_OUT_H
+
+#include "pico/fmt_printf.h"
+
+/** \file fmt_out.h
+ *
+ * \brief A buffered output that persists across printf calls
+ *
+ * A `struct fmt_out` is an output function, a buffer, and a running
+ * count, that lives as long as the destination does (rather than for
+ * just one printf call), so that many small prints are coalesced in
+ * to few large writes; the output is only passed on when the buffer
+ * fills, or when it is explicitly flushed:
+ *
+ *     static char console_buf[256];
+ *     static struct fmt_out console;
+ *     fmt_out_init(&console, console_buf, sizeof(console_buf), uart_write, uart0);
+ *     ...
+ *     fmt_out_printf(&console, "adc%d=%u ", ch, val);
+ *     ...
+ *     fmt_out_flush(&console);
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fmt_out {
+    // private
+    fmt_write_t write;
+    void *write_arg;
+    char *buf;
+    size_t size;
+    size_t len;   // how much of buf is waiting to be written
+    size_t count; // how much has been output since init
+};
+
+/**
+ * \brief Set up `o` to buffer output in the `size` bytes at `buf` before passing it on to `write`
+ *
+ * \param write The output function to pass the output on to
+ * \param write_arg The argument pointer to pass to `write`
+ */
+void fmt_out_init(struct fmt_out *o, char *buf, size_t size, fmt_write_t write, void *write_arg);
+
+/**
+ * \brief A bulk output function (fmt_write_t) that buffers its input
+ *
+ * `arg` must be a `struct fmt_out *`.  Output is passed on a full
+ * buffer at a time; except that a run that is at least as big as the
+ * buffer is passed on without being copied, if the buffer is empty.
+ */
+void fmt_out_write(const char *buf, size_t len, void *arg);
+
+int fmt_out_vprintf(struct fmt_out *o, const char *format, va_list va) [[gnu::format(printf, 2, 0)]];
+int fmt_out_printf(struct fmt_out *o, const char *format, ...) [[gnu::format(printf, 2, 3)]];
+
+/**
+ * \brief Pass on whatever output is buffered
+ */
+void fmt_out_flush(struct fmt_out *o);
+
+/**
+ * \brief How many characters have been output since init (flushed or not)
+ */
+size_t fmt_out_count(const struct fmt_out *o);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
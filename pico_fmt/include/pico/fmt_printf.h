@@ -50,6 +50,58 @@
  * \brief Compact replacement for printf by Marco Paland (info@paland.com)
  */
 
+// Optional conversions ////////////////////////////////////////////////////////
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_SLICE, Enable the %S conversion of (pointer, size_t length) strings, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_SLICE
+#define PICO_PRINTF_SUPPORT_SLICE 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_UTF8, Enable the '#' flag on %s (and %S) to count the width in UTF-8 code points and keep precision truncation on code point boundaries, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_UTF8
+#define PICO_PRINTF_SUPPORT_UTF8 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_HEXDUMP, Enable the %H hex-dump conversion of (pointer, size_t length) buffers, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_HEXDUMP
+#define PICO_PRINTF_SUPPORT_HEXDUMP 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_BASE64, Enable the %r base64 conversion of (pointer, size_t length) buffers, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_BASE64
+#define PICO_PRINTF_SUPPORT_BASE64 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_NETADDR, Enable the %I (IPv4), %lI (IPv6), and %M (MAC) network address conversions, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_NETADDR
+#define PICO_PRINTF_SUPPORT_NETADDR 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_UNITS, Enable the %K (byte size) and %T (duration) integer conversions, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_UNITS
+#define PICO_PRINTF_SUPPORT_UNITS 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_STRUCT, Enable the %R struct pretty-printer (see pico/fmt_struct.h), type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_STRUCT
+#define PICO_PRINTF_SUPPORT_STRUCT 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_BRACES, Enable fmt_vwriteformat() and friends, which take std::format-style `{}` replacement fields rather than `%` conversions, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_BRACES
+#define PICO_PRINTF_SUPPORT_BRACES 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_VALUE, Enable the %v conversion of (fmt_value_fn_t, pointer) pairs, which the C++ fmt::formatter<T> trait uses, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_VALUE
+#define PICO_PRINTF_SUPPORT_VALUE 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_QUOTE, Enable the %q conversion of C-escaped quoted strings, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_QUOTE
+#define PICO_PRINTF_SUPPORT_QUOTE 0
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -71,15 +123,256 @@ typedef void (*fmt_fct_t)(char character, void *arg);
  */
 int fmt_vfctprintf(fmt_fct_t out, void *arg, const char *format, va_list va) [[gnu::format(printf, 3, 0)]];
 
+/**
+ * \brief A bulk output function
+ */
+typedef void (*fmt_write_t)(const char *buf, size_t len, void *arg);
+
+/**
+ * \brief vprintf with bulk output function
+ *
+ * Like fmt_vfctprintf(), but the output function is handed runs of
+ * characters (such as a run of literal text, or the body of a `%s`) at
+ * once, rather than one character at a time.
+ *
+ * \param out An output function which takes a run of characters and an argument pointer
+ * \param arg An argument pointer for user data passed to output function
+ * \param format A string that specifies the format of the output
+ * \return The number of characters that are sent to the output function, not counting the terminating null character
+ */
+int fmt_vwriteprintf(fmt_write_t out, void *arg, const char *format, va_list va) [[gnu::format(printf, 3, 0)]];
+
+/**
+ * \brief vprintf with bulk output function, handing over in-place runs separately
+ *
+ * Like fmt_vwriteprintf(), but runs of characters that are a part of
+ * `format` or of a `%s` or `%S` argument are passed to `ref` rather
+ * than to `write`.  Such a `buf` stays valid for as long as the format
+ * string and the arguments do, so `ref` may keep the pointer rather
+ * than copying the characters; `buf` for `write` may point in to a
+ * temporary buffer, and must be copied.  Output from inside of a
+ * conversion (a nested fmt_state_printf() or fmt_state_convert()) all
+ * goes to `write`.
+ *
+ * \param write An output function for generated characters
+ * \param ref An output function for characters that stay in place
+ * \param arg An argument pointer for user data passed to both output functions
+ * \param format A string that specifies the format of the output
+ * \return The number of characters that are sent to the output functions, not counting the terminating null character
+ */
+int fmt_vwriterefprintf(fmt_write_t write, fmt_write_t ref, void *arg, const char *format, va_list va) [[gnu::format(printf, 4, 0)]];
+
 // Convenience functions ///////////////////////////////////////////////////////
 
 int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...) [[gnu::format(printf, 3, 4)]];
+int fmt_writeprintf(fmt_write_t out, void *arg, const char *format, ...) [[gnu::format(printf, 3, 4)]];
 
 int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list) [[gnu::format(printf, 3, 0)]];
 int fmt_snprintf(char *buffer, size_t count, const char *format, ...) [[gnu::format(printf, 3, 4)]];
 int fmt_vsprintf(char *buffer, const char *format, va_list) [[gnu::format(printf, 2, 0)]];
 int fmt_sprintf(char *buffer, const char *format, ...) [[gnu::format(printf, 2, 3)]];
 
+// Typed arguments /////////////////////////////////////////////////////////////
+
+/**
+ * \brief One argument, for calling the formatter without a va_list
+ *
+ * Front ends that know the type of each argument at compile time (such
+ * as the C++ front end in <pico/fmt.hpp>) pass an array of these
+ * instead of a va_list.  Each argument goes in the member for its type
+ * after the default argument promotions; the integer members are read
+ * back by size, so for instance a `size_t` may be stored in whichever
+ * of `i`, `l`, or `ll` is the same size as it.
+ */
+struct fmt_state;
+
+/**
+ * \brief A function that formats the value at `obj`, for `%v`
+ *
+ * Only available if pico-fmt is built with PICO_PRINTF_SUPPORT_VALUE.
+ *
+ * `%v` reads two arguments, a fmt_value_fn_t and a `const void *`, and
+ * calls the one on the other.  `state` has the flags, width, and
+ * precision of the `%v`, for the function to use as it sees fit; see
+ * <pico/fmt_install.h> for what it may do with `state`.  This is how
+ * the C++ front end calls fmt::formatter<T>.
+ */
+typedef void (*fmt_value_fn_t)(struct fmt_state *state, const void *obj);
+
+struct fmt_arg {
+    union {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        double d;
+        const void *p;
+        fmt_value_fn_t fn;
+    };
+};
+
+/**
+ * \brief printf with bulk output function, and an array of typed arguments
+ *
+ * Like fmt_vwriteprintf(), but the arguments are read from `argv`
+ * rather than from a va_list.  Nothing checks that `argv` matches
+ * `format`; that is the caller's job.
+ */
+int fmt_writeprintf_argv(fmt_write_t out, void *arg, const char *format, const struct fmt_arg *argv);
+
+// Replacement-field syntax //////////////////////////////////////////////////
+
+/**
+ * \brief Like fmt_vwriteprintf(), but with `{}` fields rather than `%` conversions
+ *
+ * Only available if pico-fmt is built with PICO_PRINTF_SUPPORT_BRACES.
+ *
+ * A replacement field is `{}` or `{:spec}`, where `spec` is the
+ * std::format-style `[[fill]align][sign][#][0][width][.precision][type]`,
+ * with an optional printf size (`l`, `ll`, `h`, `hh`, `z`, `j`, or
+ * `t`) before the type.  The type may be any specifier character,
+ * including those registered with fmt_install(); the rest is turned
+ * in to the same flags, width, and precision as the `%` syntax (as
+ * in std::format, strings and characters are left-aligned unless
+ * the align says otherwise).  `{{` and `}}` are literal braces.  Not
+ * supported are: argument numbers, `{}` widths or precisions, fills
+ * other than a space, and `^` centering.
+ *
+ * A va_list doesn't say what type its arguments are, so here each
+ * field must have a type (`{:d}`, `{:>8s}`, `{:lu}`); fmt::format_to()
+ * in <pico/fmt.hpp> works the type out from the argument instead, so
+ * that `{}` and `{:x}` work there.
+ */
+int fmt_vwriteformat(fmt_write_t out, void *arg, const char *format, va_list va);
+int fmt_writeformat(fmt_write_t out, void *arg, const char *format, ...);
+
+/**
+ * \brief fmt_vwriteformat() with an array of typed arguments
+ *
+ * \param types For each argument, the size and type (as in printf,
+ *     such as "lu") to use where a field doesn't say; or NULL
+ */
+int fmt_writeformat_argv(fmt_write_t out, void *arg, const char *format, const struct fmt_arg *argv, const char *const *types);
+
+// Pulling output in chunks ////////////////////////////////////////////////////
+
+/**
+ * \brief printf output that is read a chunk at a time
+ *
+ * Rather than the formatter pushing the output to an output function,
+ * the caller pulls it out, a buffer-full at a time, so that a long
+ * output can be sent as it is formatted, with only a packet-sized
+ * buffer:
+ *
+ *     struct fmt_stream s;
+ *     char pkt[64];
+ *     size_t n;
+ *     fmt_stream_init(&s, format, va);
+ *     while ((n = fmt_stream_read(&s, pkt, sizeof(pkt))))
+ *         usb_send(pkt, n);
+ *     fmt_stream_end(&s);
+ *
+ * The stream remembers how far through the format string and the
+ * arguments it is, and how much of the current conversion has been
+ * read; a conversion that doesn't fit in one read is run again by the
+ * next read, which skips the part that has already been read.  So
+ * conversions (including ones registered with fmt_install()) must
+ * give the same output each time that they are run.
+ *
+ * As each of those reads runs the conversion all the way through, one
+ * conversion that is L characters long costs time quadratic in L: a
+ * 4 KiB `%H` read 64 bytes at a time is run 64 times, formatting some
+ * 256 KiB to deliver 4 KiB.  Read in chunks that are about as big as
+ * the biggest conversion, or split a big conversion in to several
+ * (for example, `%H` of each 256 bytes of a dump).
+ */
+struct fmt_stream {
+    // private
+    const char *format; // the rest of the format string
+    va_list va;         // the arguments, from the current conversion
+    size_t skip;        // how much of the current conversion has been read
+};
+
+/**
+ * \brief Start streaming `format`
+ *
+ * `va` is copied, but the arguments that it refers to must stay valid
+ * until fmt_stream_end(); so the function that did va_start() must not
+ * return before then.
+ */
+void fmt_stream_init(struct fmt_stream *s, const char *format, va_list va) [[gnu::format(printf, 2, 0)]];
+
+/**
+ * \brief Read the next up-to-`len` characters of the output in to `buf`
+ *
+ * It does not NUL-terminate `buf`.
+ *
+ * \return The number of characters read; which is less than `len` only
+ *     at the end of the output, and 0 after the end
+ */
+size_t fmt_stream_read(struct fmt_stream *s, char *buf, size_t len);
+
+/**
+ * \brief Skip over the next up-to-`len` characters of the output
+ *
+ * This is cheaper than reading them: conversions that are skipped
+ * over entirely are only run to count their length (as when
+ * fmt_vsnprintf() is given a NULL buffer), and runs of literal text
+ * are stepped over whole.  It is still linear in `len`, though, as
+ * each of those conversions must be run to find out how long it is.
+ *
+ * \return The number of characters skipped; which is less than `len`
+ *     only at the end of the output
+ */
+size_t fmt_stream_skip(struct fmt_stream *s, size_t len);
+
+/**
+ * \brief Release `s` (whether or not it has been read to the end)
+ */
+void fmt_stream_end(struct fmt_stream *s);
+
+/**
+ * \brief Format just the characters [offset, offset+len) of the output in to `buf`
+ *
+ * For paging through a long output: fmt_stream_skip() over the first
+ * `offset` characters, then fmt_stream_read() the next `len`.  It does
+ * not NUL-terminate `buf`.
+ *
+ * Skipping is cheaper than formatting, but the cost is still linear in
+ * `offset`, not constant: page N of a long output costs running every
+ * conversion on pages 0 through N-1 in length-only mode.
+ *
+ * \return The number of characters written to `buf`; which is less
+ *     than `len` only if the output ends inside of the window
+ */
+size_t fmt_vwindowprintf(char *buf, size_t offset, size_t len, const char *format, va_list va) [[gnu::format(printf, 4, 0)]];
+size_t fmt_windowprintf(char *buf, size_t offset, size_t len, const char *format, ...) [[gnu::format(printf, 4, 5)]];
+
+// Cooperative yielding ////////////////////////////////////////////////////////
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_YIELD, Enable the fmt_set_yield() cooperative yield hook, type=bool, default=0, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_YIELD
+#define PICO_PRINTF_SUPPORT_YIELD 0
+#endif
+
+/**
+ * \brief A function that yields the processor to other tasks
+ */
+typedef void (*fmt_yield_t)(void);
+
+/**
+ * \brief Have long-running printf calls periodically yield to other tasks
+ *
+ * Only available if pico-fmt is built with PICO_PRINTF_SUPPORT_YIELD.
+ *
+ * \param fn The function to call, or NULL to disable yielding
+ * \param every_n_bytes Call `fn` after every this-many bytes of output;
+ *     or if 0, after each conversion (each `%` specifier)
+ */
+#if PICO_PRINTF_SUPPORT_YIELD
+void fmt_set_yield(fmt_yield_t fn, size_t every_n_bytes);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
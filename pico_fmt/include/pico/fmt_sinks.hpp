@@ -0,0 +1,121 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_SINKS_HPP
+#define _PICO_FMT_SINKS_HPP
+
+#include <algorithm>   /* for std::copy */
+#include <cstring>     /* for std::memcpy */
+#include <span>        /* for std::span */
+#include <string>      /* for std::string */
+#include <string_view> /* for std::string_view */
+
+#include "pico/fmt.hpp"
+
+/** \file fmt_sinks.hpp
+ *
+ * \brief Sinks for fmt::print_to() and fmt::format_to() that write to C++ containers
+ *
+ * Each of these is handed the output a run at a time (the body of a
+ * `%s`, a rendered number, a span of the format string) by the bulk
+ * fmt_write_t interface, so the output goes straight to where it is
+ * going, without being formatted to a stack buffer first:
+ *
+ *     std::string log;
+ *     fmt::print_to(fmt::string_sink{log}, "[%8lu] %s\n", now, msg);
+ *
+ *     char pkt[64];
+ *     fmt::span_sink sink{pkt};
+ *     fmt::print_to(sink, "%s=%d", key, val);
+ *     usb_send(pkt, sink.len);
+ *
+ *     std::vector<char> v;
+ *     fmt::print_to(fmt::iterator_sink{std::back_inserter(v)}, "%d", 42);
+ *
+ * fmt::sprint() and fmt::format() return a new std::string, sized by a
+ * length-only pass first, so that it is allocated exactly once.
+ */
+
+namespace fmt {
+
+/**
+ * \brief A sink that appends to a std::string
+ *
+ * This leaves it to std::string's (geometric) growth to amortize the
+ * allocations over many appends; reserve() the string first if you
+ * know about how long it will get.
+ */
+struct string_sink {
+    std::string &str;
+
+    void operator()(const char *buf, std::size_t len) {
+        str.append(buf, len);
+    }
+};
+
+/**
+ * \brief A sink that writes in to a fixed buffer, dropping whatever doesn't fit
+ *
+ * It doesn't NUL-terminate the buffer.  The count that print_to()
+ * returns is of the full output, so that it being greater than `len`
+ * says that the output was truncated.
+ */
+struct span_sink {
+    std::span<char> buf;
+    std::size_t len = 0; // how much of buf has been written
+
+    void operator()(const char *p, std::size_t n) {
+        if (n > buf.size() - len)
+            n = buf.size() - len;
+        if (!n)
+            return;
+        std::memcpy(buf.data() + len, p, n);
+        len += n;
+    }
+
+    std::string_view view() const {
+        return std::string_view(buf.data(), len);
+    }
+};
+
+/**
+ * \brief A sink that pushes each character through an output iterator
+ */
+template <typename OutputIt>
+struct iterator_sink {
+    OutputIt it;
+
+    void operator()(const char *buf, std::size_t len) {
+        it = std::copy(buf, buf + len, it);
+    }
+};
+
+/**
+ * \brief printf to a new std::string
+ */
+template <typename... Args>
+std::string sprint(format_string<std::decay_t<const Args &>...> format, const Args &...args) {
+    std::string str;
+    str.resize(static_cast<std::size_t>(print_to(nullptr, format, args...)));
+    print_to(span_sink{str}, format, args...);
+    return str;
+}
+
+#if PICO_PRINTF_SUPPORT_BRACES
+/**
+ * \brief format_to() a new std::string
+ *
+ * Only available if pico-fmt is built with PICO_PRINTF_SUPPORT_BRACES.
+ */
+template <typename... Args>
+std::string format(brace_format_string<std::decay_t<const Args &>...> format, const Args &...args) {
+    std::string str;
+    str.resize(static_cast<std::size_t>(format_to(nullptr, format, args...)));
+    format_to(span_sink{str}, format, args...);
+    return str;
+}
+#endif
+
+} // namespace fmt
+
+#endif
@@ -0,0 +1,458 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_STATIC_HPP
+#define _PICO_FMT_STATIC_HPP
+
+#include <cstddef> /* for std::size_t, std::ptrdiff_t */
+#include <cstdint> /* for std::intmax_t */
+
+#include "pico/fmt.hpp"
+#include "pico/fmt_install.h" /* for fmt_flags, FMT_FLAG_*, enum fmt_size */
+
+/** \file fmt_static.hpp
+ *
+ * \brief Formatting at compile time, in to a constant char array
+ *
+ * FMT_STATIC_SPRINT() takes a format string and arguments that are all
+ * constant expressions, and formats them while compiling, giving a
+ * `fmt::static_string` that is exactly as long as the output; so a
+ * banner or a version string can be built from constants without
+ * spending boot time or RAM on it:
+ *
+ *     static constexpr auto banner = FMT_STATIC_SPRINT("%s v%d.%d.%d (%08x)\n",
+ *                                                      PRODUCT, VER_MAJOR, VER_MINOR, VER_PATCH, GIT_HASH);
+ *     uart_puts(uart0, banner.c_str());
+ *
+ * The engine in printf.c can't be run by the compiler, so this has
+ * its own constexpr copy of the integer, character, and string
+ * conversions (`%d %i %u %x %X %o %b %c %s %%`, with all of the flags,
+ * widths, precisions, and sizes), which give the same output as the
+ * engine built with the default configuration.  Any other conversion
+ * is a compile error (in addition to the checks of fmt::print_to()):
+ * `fmt::detail::conversion_not_supported_at_compile_time()`.
+ *
+ * The arguments are evaluated in a lambda, so a local variable must be
+ * `static constexpr` (not just `constexpr`) to be used as one.
+ */
+
+namespace fmt {
+
+/**
+ * \brief A NUL-terminated string of length `N`, formatted at compile time
+ */
+template <std::size_t N>
+struct static_string {
+    char buf[N + 1];
+
+    constexpr const char *c_str() const { return buf; }
+    constexpr const char *data() const { return buf; }
+    static constexpr std::size_t size() { return N; }
+};
+
+namespace detail {
+
+inline void conversion_not_supported_at_compile_time() {}
+
+// An argument, in a form that can be read at compile time.
+struct const_arg {
+    long long i;
+    unsigned long long u;
+    const char *s;
+};
+
+template <typename T>
+constexpr const_arg make_const_arg(T v) {
+    constexpr arg_type t = type_of<T>();
+    if constexpr (t == ARG_INT || t == ARG_LONG || t == ARG_LONG_LONG)
+        return {static_cast<long long>(v), static_cast<unsigned long long>(v), nullptr};
+    else if constexpr (t == ARG_STR)
+        return {0, 0, v};
+    else
+        return {}; // the check rejects it, or the conversion that reads it does
+}
+
+// Counts the output, and stores as much of it as fits in `buf`.
+struct const_writer {
+    char *buf;
+    std::size_t cap;
+    std::size_t len;
+
+    constexpr void putchar(char c) {
+        if (len < cap)
+            buf[len] = c;
+        len++;
+    }
+};
+
+// The constexpr counterpart of `struct fmt_state`.
+struct const_state {
+    fmt_flags flags;
+    unsigned int width;
+    unsigned int precision;
+    enum fmt_size size;
+    char specifier;
+
+    const const_arg *argv;
+    const_writer *w;
+};
+
+constexpr void const_pad(const_state &state, std::size_t n) {
+    while (n--)
+        state.w->putchar(' ');
+}
+
+// printf.c:_ntoa(), _ntoa_intro(), and _ntoa_outro()
+constexpr void const_ntoa(const_state &state, unsigned long long absval, bool negative, unsigned int base) {
+    const std::size_t start_idx = state.w->len;
+    unsigned int ndigits = 0;
+    unsigned long long div = 1;
+    if (absval) {
+        ndigits = 1;
+        while (absval / div >= base) {
+            div *= base;
+            ndigits++;
+        }
+    }
+    const int sign = absval ? (negative ? -1 : 1) : 0;
+    const bool hash = (state.flags & FMT_FLAG_HASH) && sign != 0;
+
+    unsigned int nextra = 0;
+    switch (base) {
+        case 2:
+        case 16:
+            nextra = hash ? 2 : 0;
+            break;
+        case 8:
+            nextra = hash ? 1 : 0;
+            break;
+        case 10:
+            nextra = ((state.flags & (FMT_FLAG_PLUS | FMT_FLAG_SPACE)) || sign < 0) ? 1 : 0;
+            break;
+    }
+
+    if (state.flags & FMT_FLAG_PRECISION)
+        state.flags &= static_cast<fmt_flags>(~FMT_FLAG_ZEROPAD);
+
+    const bool zero_digit = sign == 0 && !(state.flags & FMT_FLAG_PRECISION);
+    if (zero_digit)
+        ndigits = 1;
+
+    // leading spaces
+    if (state.width && !(state.flags & (FMT_FLAG_LEFT | FMT_FLAG_ZEROPAD)))
+        for (unsigned int i = (state.precision > ndigits ? state.precision : ndigits) + nextra; i < state.width; i++)
+            state.w->putchar(' ');
+
+    // base or sign
+    switch (base) {
+        case 2:
+        case 16:
+            if (hash) {
+                state.w->putchar('0');
+                state.w->putchar(base == 2 ? 'b' : state.specifier);
+            }
+            break;
+        case 8:
+            if (hash)
+                state.w->putchar('0');
+            break;
+        case 10:
+            if (sign < 0)
+                state.w->putchar('-');
+            else if (state.flags & FMT_FLAG_PLUS)
+                state.w->putchar('+');
+            else if (state.flags & FMT_FLAG_SPACE)
+                state.w->putchar(' ');
+            break;
+    }
+
+    // leading zeros
+    if (state.flags & FMT_FLAG_PRECISION) {
+        for (unsigned int i = ndigits; i < state.precision; i++)
+            state.w->putchar('0');
+    } else if (state.width && !(state.flags & FMT_FLAG_LEFT) && (state.flags & FMT_FLAG_ZEROPAD)) {
+        for (unsigned int i = ndigits + nextra; i < state.width; i++)
+            state.w->putchar('0');
+    }
+    if (zero_digit)
+        state.w->putchar('0');
+
+    // the number (which zero_digit has already done, if it's zero)
+    const char alpha = (state.specifier >= 'A' && state.specifier <= 'Z') ? 'A' : 'a';
+    for (unsigned int i = 0; sign != 0 && i < ndigits; i++) {
+        const auto digit = static_cast<char>(absval / div);
+        absval %= div;
+        div /= base;
+        state.w->putchar(static_cast<char>(digit < 10 ? '0' + digit : alpha + digit - 10));
+    }
+
+    // trailing spaces
+    for (std::size_t len = state.w->len - start_idx; len < state.width; len++)
+        state.w->putchar(' ');
+}
+
+// printf.c:conv_sint()
+constexpr void const_sint(const_state &state) {
+    long long value = 0;
+    switch (state.size) {
+        case FMT_SIZE_LONG_LONG:
+            value = state.argv->i;
+            break;
+        case FMT_SIZE_LONG:
+            value = static_cast<long>(state.argv->i);
+            break;
+        case FMT_SIZE_DEFAULT:
+            value = static_cast<int>(state.argv->i);
+            break;
+        case FMT_SIZE_SHORT:
+            value = static_cast<short>(static_cast<int>(state.argv->i));
+            break;
+        case FMT_SIZE_CHAR:
+            value = static_cast<char>(static_cast<int>(state.argv->i));
+            break;
+    }
+    state.argv++;
+    const_ntoa(state, value > 0 ? static_cast<unsigned long long>(value) : 0U - static_cast<unsigned long long>(value), value < 0, 10);
+}
+
+// printf.c:conv_uint()
+constexpr void const_uint(const_state &state) {
+    unsigned int base = 10;
+    switch (state.specifier) {
+        case 'x':
+        case 'X':
+            base = 16;
+            break;
+        case 'o':
+            base = 8;
+            break;
+        case 'b':
+            base = 2;
+            break;
+        default:
+            state.flags &= static_cast<fmt_flags>(~(FMT_FLAG_PLUS | FMT_FLAG_SPACE));
+            break;
+    }
+    unsigned long long value = 0;
+    switch (state.size) {
+        case FMT_SIZE_LONG_LONG:
+            value = state.argv->u;
+            break;
+        case FMT_SIZE_LONG:
+            value = static_cast<unsigned long>(state.argv->u);
+            break;
+        case FMT_SIZE_DEFAULT:
+            value = static_cast<unsigned int>(state.argv->u);
+            break;
+        case FMT_SIZE_SHORT:
+            value = static_cast<unsigned short>(state.argv->u);
+            break;
+        case FMT_SIZE_CHAR:
+            value = static_cast<unsigned char>(state.argv->u);
+            break;
+    }
+    state.argv++;
+    const_ntoa(state, value, false, base);
+}
+
+// printf.c:conv_char()
+constexpr void const_char(const_state &state) {
+    const std::size_t pad = state.width > 1U ? state.width - 1U : 0U;
+    if (!(state.flags & FMT_FLAG_LEFT))
+        const_pad(state, pad);
+    state.w->putchar(static_cast<char>(static_cast<int>((state.argv++)->i)));
+    if (state.flags & FMT_FLAG_LEFT)
+        const_pad(state, pad);
+}
+
+// printf.c:conv_str()
+constexpr void const_str(const_state &state) {
+#if PICO_PRINTF_SUPPORT_UTF8
+    if (state.flags & FMT_FLAG_HASH)
+        conversion_not_supported_at_compile_time();
+#endif
+    const char *p = (state.argv++)->s;
+    std::size_t l = 0;
+    while (p[l] && (!(state.flags & FMT_FLAG_PRECISION) || l < state.precision))
+        l++;
+    const std::size_t pad = l < state.width ? state.width - l : 0U;
+    if (!(state.flags & FMT_FLAG_LEFT))
+        const_pad(state, pad);
+    for (std::size_t i = 0; i < l; i++)
+        state.w->putchar(p[i]);
+    if (state.flags & FMT_FLAG_LEFT)
+        const_pad(state, pad);
+}
+
+constexpr unsigned int const_atoi(const char *&p) {
+    unsigned int i = 0;
+    while (is_digit(*p))
+        i = i * 10U + static_cast<unsigned int>(*p++ - '0');
+    return i;
+}
+
+// printf.c:_parse_size()
+constexpr const char *const_parse_size(const_state &state, const char *format) {
+    state.size = FMT_SIZE_DEFAULT;
+    switch (*format) {
+        case 'l':
+            state.size = FMT_SIZE_LONG;
+            if (*++format == 'l') {
+                state.size = FMT_SIZE_LONG_LONG;
+                format++;
+            }
+            break;
+        case 'h':
+            state.size = FMT_SIZE_SHORT;
+            if (*++format == 'h') {
+                state.size = FMT_SIZE_CHAR;
+                format++;
+            }
+            break;
+        case 't':
+            state.size = sizeof(std::ptrdiff_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG;
+            format++;
+            break;
+        case 'j':
+            state.size = sizeof(std::intmax_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG;
+            format++;
+            break;
+        case 'z':
+            state.size = sizeof(std::size_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG;
+            format++;
+            break;
+        default:
+            break;
+    }
+    return format;
+}
+
+// printf.c:_vfctprintf()
+constexpr void const_vprintf(const_writer &w, const char *format, const const_arg *argv) {
+    const_state state = {};
+    state.argv = argv;
+    state.w = &w;
+
+    while (*format) {
+        if (*format != '%') {
+            w.putchar(*format++);
+            continue;
+        }
+        format++;
+
+        // flags
+        state.flags = 0U;
+        for (;; format++) {
+            if (*format == '0')
+                state.flags |= FMT_FLAG_ZEROPAD;
+            else if (*format == '-')
+                state.flags |= FMT_FLAG_LEFT;
+            else if (*format == '+')
+                state.flags |= FMT_FLAG_PLUS;
+            else if (*format == ' ')
+                state.flags |= FMT_FLAG_SPACE;
+            else if (*format == '#')
+                state.flags |= FMT_FLAG_HASH;
+            else
+                break;
+        }
+
+        // width
+        state.width = 0U;
+        if (is_digit(*format)) {
+            state.width = const_atoi(format);
+        } else if (*format == '*') {
+            const int width = static_cast<int>((state.argv++)->i);
+            if (width < 0) {
+                state.flags |= FMT_FLAG_LEFT;
+                state.width = 0U - static_cast<unsigned int>(width);
+            } else {
+                state.width = static_cast<unsigned int>(width);
+            }
+            format++;
+        }
+
+        // precision
+        state.precision = 0U;
+        if (*format == '.') {
+            state.flags |= FMT_FLAG_PRECISION;
+            format++;
+            if (is_digit(*format)) {
+                state.precision = const_atoi(format);
+            } else if (*format == '*') {
+                const int prec = static_cast<int>((state.argv++)->i);
+                if (prec < 0)
+                    state.flags &= static_cast<fmt_flags>(~FMT_FLAG_PRECISION);
+                else
+                    state.precision = static_cast<unsigned int>(prec);
+                format++;
+            }
+        }
+
+        // size
+        format = const_parse_size(state, format);
+
+        // specifier
+        state.specifier = *format++;
+        switch (state.specifier) {
+            case 'd':
+            case 'i':
+                const_sint(state);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'b':
+                const_uint(state);
+                break;
+            case 'c':
+                const_char(state);
+                break;
+            case 's':
+                const_str(state);
+                break;
+            case '%':
+                w.putchar('%');
+                break;
+            default:
+                conversion_not_supported_at_compile_time();
+        }
+    }
+}
+
+template <typename... Args>
+constexpr void const_print_to(const_writer &w, format_string<std::decay_t<Args>...> format, Args... args) {
+    const const_arg argv[sizeof...(Args) + 1] = {make_const_arg<std::decay_t<Args>>(args)..., {}};
+    const_vprintf(w, format.str, argv);
+}
+
+// Run `Fn` once to measure the output, and again to store it.
+template <auto Fn>
+consteval auto static_sprint() {
+    constexpr std::size_t n = [] {
+        const_writer w = {nullptr, 0, 0};
+        Fn(w);
+        return w.len;
+    }();
+    static_string<n> ret = {};
+    const_writer w = {ret.buf, n, 0};
+    Fn(w);
+    return ret;
+}
+
+} // namespace detail
+
+} // namespace fmt
+
+/**
+ * \brief printf at compile time, to a fmt::static_string
+ *
+ * FMT_STATIC_SPRINT(format, args...)
+ */
+#define FMT_STATIC_SPRINT(...)                                              \
+    (::fmt::detail::static_sprint<[](::fmt::detail::const_writer &_fmt_w) { \
+        ::fmt::detail::const_print_to(_fmt_w, __VA_ARGS__);                 \
+    }>())
+
+#endif
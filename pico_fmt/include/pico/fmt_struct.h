@@ -0,0 +1,126 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_STRUCT_H
+#define _PICO_FMT_STRUCT_H
+
+#include <stddef.h> /* for offsetof */
+#include <stdint.h> /* for uint8_t, uint16_t */
+
+/** \file fmt_struct.h
+ *
+ * \brief Field descriptor tables for the `%R` struct pretty-printer
+ *
+ * With `PICO_PRINTF_SUPPORT_STRUCT=1`, `%R` takes a pointer to a struct
+ * and a pointer to a `struct fmt_struct` that describes it, and prints
+ * every described field in one pass:
+ *
+ *     struct uart_cfg {
+ *         uint32_t baud;
+ *         uint8_t mode;
+ *         uint16_t flags;
+ *         char name[8];
+ *     };
+ *     static const char *const mode_names[] = {"OFF", "RX", "TX", "RXTX"};
+ *     static const char *const flag_names[] = {"PARITY", "STOP2", "CTS", "RTS"};
+ *     static const struct fmt_field uart_cfg_fields[] = {
+ *         FMT_FIELD(struct uart_cfg, baud, FMT_FIELD_UINT, FMT_DISPLAY_DEC),
+ *         FMT_FIELD_NAMES(struct uart_cfg, mode, FMT_FIELD_UINT, FMT_DISPLAY_ENUM, mode_names),
+ *         FMT_FIELD_NAMES(struct uart_cfg, flags, FMT_FIELD_UINT, FMT_DISPLAY_FLAGS, flag_names),
+ *         FMT_FIELD(struct uart_cfg, name, FMT_FIELD_CHARS, FMT_DISPLAY_DEC),
+ *     };
+ *     static const struct fmt_struct uart_cfg_desc = FMT_STRUCT(uart_cfg_fields);
+ *
+ *     fmt_printf("%R\n", &cfg, &uart_cfg_desc);
+ *     // {baud=115200, mode=RXTX, flags=PARITY|CTS, name="uart0"}
+ *
+ * With the `#` flag, each field is instead put on its own line, as
+ * "name=value\n".
+ *
+ * The descriptors are meant to be `static const`, so that everything
+ * about each field (where it is, how wide it is, how to render it, and
+ * the length of its name) is worked out at compile time, and printing
+ * the struct is only a walk over the table.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum fmt_field_type {
+    FMT_FIELD_UINT,  // an unsigned integer of 1, 2, 4, or 8 bytes
+    FMT_FIELD_SINT,  // a signed integer of 1, 2, 4, or 8 bytes
+    FMT_FIELD_BOOL,  // a `bool`; "true" or "false"
+    FMT_FIELD_STR,   // a `const char *` to a NUL-terminated string; quoted
+    FMT_FIELD_CHARS, // a `char[N]`, up to the first NUL if there is one; quoted
+};
+
+enum fmt_field_display {
+    FMT_DISPLAY_DEC,   // decimal
+    FMT_DISPLAY_HEX,   // "0x"-prefixed hex, zero-padded to the size of the field
+    FMT_DISPLAY_ENUM,  // names[value], or decimal if there is no such name
+    FMT_DISPLAY_FLAGS, // names[bit] of each set bit, joined with '|'; any
+                       // bits without a name as hex
+};
+
+struct fmt_field {
+    const char *name;
+    uint8_t name_len;
+    uint8_t type;    // enum fmt_field_type
+    uint8_t display; // enum fmt_field_display; ignored by non-integer types
+    uint8_t size;    // sizeof() the member
+    uint16_t offset; // offsetof() the member
+    uint8_t nnames;
+    const char *const *names; // for FMT_DISPLAY_ENUM and FMT_DISPLAY_FLAGS; may contain NULLs
+};
+
+struct fmt_struct {
+    size_t nfields;
+    const struct fmt_field *fields;
+};
+
+#define FMT_FIELD(STRUCT, MEMBER, TYPE, DISPLAY) \
+    _FMT_FIELD(STRUCT, MEMBER, TYPE, DISPLAY, 0, NULL)
+
+#define FMT_FIELD_NAMES(STRUCT, MEMBER, TYPE, DISPLAY, NAMES) \
+    _FMT_FIELD(STRUCT, MEMBER, TYPE, DISPLAY, sizeof(NAMES) / sizeof((NAMES)[0]), (NAMES))
+
+#define _FMT_FIELD(STRUCT, MEMBER, TYPE, DISPLAY, NNAMES, NAMES)       \
+    {                                                                  \
+        .name = #MEMBER,                                               \
+        .name_len = sizeof(#MEMBER) - 1,                               \
+        .type = (TYPE),                                                \
+        .display = (DISPLAY),                                          \
+        .size = _FMT_FIELD_SIZE(TYPE, sizeof(((STRUCT *) 0)->MEMBER)), \
+        .offset = offsetof(STRUCT, MEMBER),                            \
+        .nnames = (NNAMES),                                            \
+        .names = (NAMES),                                              \
+    }
+
+// Evaluates to SIZE, but fails to compile if an integer field is not
+// 1, 2, 4, or 8 bytes, as those are the only sizes %R can load.
+#ifdef __cplusplus
+#define _FMT_FIELD_SIZE(TYPE, SIZE) \
+    ((SIZE) + 0 * sizeof(char[_FMT_FIELD_SIZE_OK(TYPE, SIZE) ? 1 : -1]))
+#else
+#define _FMT_FIELD_SIZE(TYPE, SIZE)                                                                            \
+    ((SIZE) + 0 * sizeof(struct {                                                                              \
+                  _Static_assert(_FMT_FIELD_SIZE_OK(TYPE, SIZE), "integer field must be 1, 2, 4, or 8 bytes"); \
+                  char _c;                                                                                     \
+              }))
+#endif
+#define _FMT_FIELD_SIZE_OK(TYPE, SIZE)                         \
+    (((TYPE) != FMT_FIELD_UINT && (TYPE) != FMT_FIELD_SINT) || \
+     (SIZE) == 1 || (SIZE) == 2 || (SIZE) == 4 || (SIZE) == 8)
+
+#define FMT_STRUCT(FIELDS)                               \
+    {                                                    \
+        .nfields = sizeof(FIELDS) / sizeof((FIELDS)[0]), \
+        .fields = (FIELDS),                              \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pico/fmt_iovec.h"
+
+void fmt_iovec_init(struct fmt_iovec *v, struct fmt_iov *iov, size_t iov_max, char *scratch, size_t scratch_size) {
+    v->iov = iov;
+    v->iov_max = iov_max;
+    v->iov_cnt = 0;
+    v->scratch = scratch;
+    v->scratch_size = scratch_size;
+    v->scratch_len = 0;
+    v->truncated = false;
+}
+
+// \return Whether `buf` carries straight on from the end of the last entry.
+static inline bool _follows(const struct fmt_iovec *v, const char *buf) {
+    return v->iov_cnt && v->iov[v->iov_cnt - 1].base + v->iov[v->iov_cnt - 1].len == buf;
+}
+
+static bool _add(struct fmt_iovec *v, const char *buf, size_t len) {
+    if (_follows(v, buf)) {
+        v->iov[v->iov_cnt - 1].len += len;
+        return true;
+    }
+    if (v->iov_cnt == v->iov_max) {
+        v->truncated = true;
+        return false;
+    }
+    v->iov[v->iov_cnt].base = buf;
+    v->iov[v->iov_cnt].len = len;
+    v->iov_cnt++;
+    return true;
+}
+
+void fmt_iovec_write(const char *buf, size_t len, void *arg) {
+    struct fmt_iovec *v = arg;
+    if (v->truncated)
+        return;
+    size_t n = v->scratch_size - v->scratch_len;
+    if (n > len)
+        n = len;
+    char *dst = &v->scratch[v->scratch_len];
+    for (size_t i = 0; i < n; i++)
+        dst[i] = buf[i];
+    if (n && _add(v, dst, n))
+        v->scratch_len += n;
+    if (n < len)
+        v->truncated = true;
+}
+
+void fmt_iovec_ref(const char *buf, size_t len, void *arg) {
+    struct fmt_iovec *v = arg;
+    if (v->truncated)
+        return;
+    // a short run is cheaper to copy than to give an entry of its own
+    if (!_follows(v, buf) && len < sizeof(struct fmt_iov) && len <= v->scratch_size - v->scratch_len) {
+        fmt_iovec_write(buf, len, v);
+        return;
+    }
+    _add(v, buf, len);
+}
+
+int fmt_iovec_vprintf(struct fmt_iovec *v, const char *format, va_list va) {
+    return fmt_vwriterefprintf(fmt_iovec_write, fmt_iovec_ref, v, format, va);
+}
+
+int fmt_iovec_printf(struct fmt_iovec *v, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_iovec_vprintf(v, format, va);
+    va_end(va);
+    return ret;
+}
+
+size_t fmt_iovec_count(const struct fmt_iovec *v) {
+    return v->iov_cnt;
+}
+
+bool fmt_iovec_truncated(const struct fmt_iovec *v) {
+    return v->truncated;
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pico/fmt_out.h"
+
+void fmt_out_init(struct fmt_out *o, char *buf, size_t size, fmt_write_t write, void *write_arg) {
+    o->write = write;
+    o->write_arg = write_arg;
+    o->buf = buf;
+    o->size = size;
+    o->len = 0;
+    o->count = 0;
+}
+
+void fmt_out_flush(struct fmt_out *o) {
+    if (o->len)
+        o->write(o->buf, o->len, o->write_arg);
+    o->len = 0;
+}
+
+void fmt_out_write(const char *buf, size_t len, void *arg) {
+    struct fmt_out *o = arg;
+    o->count += len;
+    while (len) {
+        if (!o->len && len >= o->size) {
+            // too big to be worth buffering
+            o->write(buf, len, o->write_arg);
+            return;
+        }
+        size_t n = o->size - o->len;
+        if (n > len)
+            n = len;
+        for (size_t i = 0; i < n; i++)
+            o->buf[o->len + i] = buf[i];
+        o->len += n;
+        buf += n;
+        len -= n;
+        if (o->len == o->size)
+            fmt_out_flush(o);
+    }
+}
+
+int fmt_out_vprintf(struct fmt_out *o, const char *format, va_list va) {
+    return fmt_vwriteprintf(fmt_out_write, o, format, va);
+}
+
+int fmt_out_printf(struct fmt_out *o, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_out_vprintf(o, format, va);
+    va_end(va);
+    return ret;
+}
+
+size_t fmt_out_count(const struct fmt_out *o) {
+    return o->count;
+}
@@ -41,9 +41,11 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h> // for memcpy
 
 #include "pico/fmt_install.h"
 #include "pico/fmt_printf.h"
+#include "pico/fmt_struct.h"
 
 // PICO_CONFIG: PICO_PRINTF_FTOA_BUFFER_SIZE, Define printf ftoa buffer size, min=0, max=128, default=32, group=pico_printf
 // 'ftoa' conversion buffer size, this must be big enough to hold one converted
@@ -85,6 +87,18 @@
 #define PICO_PRINTF_SUPPORT_PTRDIFF_T 1
 #endif
 
+// PICO_CONFIG: PICO_PRINTF_MAX_WIDTH, Define the largest width that a conversion may be padded to (0 for no limit), min=0, default=0, group=pico_printf
+// a conversion with a larger width is replaced by an error, rather than
+// spending time on printing all of that padding
+#ifndef PICO_PRINTF_MAX_WIDTH
+#define PICO_PRINTF_MAX_WIDTH 0
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_MAX_PRECISION, Define the largest precision that a conversion may have (0 for no limit), min=0, default=0, group=pico_printf
+#ifndef PICO_PRINTF_MAX_PRECISION
+#define PICO_PRINTF_MAX_PRECISION 0
+#endif
+
 // import float.h for DBL_MAX
 #if PICO_PRINTF_SUPPORT_FLOAT
 #include <float.h>
@@ -96,11 +110,37 @@ struct _fmt_ctx {
     fmt_fct_t fct;
     void *arg;
     size_t idx;
+    // For fmt_vwriteprintf(); `fct` is then _out_write1() with `arg`
+    // pointing at the ctx itself, so that fmt_state_putchar() need
+    // not care which kind of output function it has.
+    fmt_write_t write;
+    void *write_arg;
+    // For fmt_vwriterefprintf(); otherwise NULL.
+    fmt_write_t ref;
+#if PICO_PRINTF_SUPPORT_YIELD
+    size_t yield_countdown;
+#endif
 };
 
+#if PICO_PRINTF_SUPPORT_YIELD
+static fmt_yield_t _yield_fn;
+static size_t _yield_every;
+
+void fmt_set_yield(fmt_yield_t fn, size_t every_n_bytes) {
+    _yield_fn = fn;
+    _yield_every = fn ? every_n_bytes : 0;
+}
+#endif
+
 inline void fmt_state_putchar(struct fmt_state *state, char character) {
     if (state->ctx->fct) {
         state->ctx->fct(character, state->ctx->arg);
+#if PICO_PRINTF_SUPPORT_YIELD
+        if (_yield_every && !--state->ctx->yield_countdown) {
+            state->ctx->yield_countdown = _yield_every;
+            _yield_fn();
+        }
+#endif
     }
     state->ctx->idx++;
 }
@@ -110,6 +150,49 @@ inline void fmt_state_puts(struct fmt_state *state, const char *str) {
         fmt_state_putchar(state, *(str++));
 }
 
+// Output `len` characters at once; with `write` (either ctx->write or
+// ctx->ref), if there is a bulk output function.
+static void _out_bulk(struct fmt_state *state, fmt_write_t write, const char *buf, size_t len) {
+    struct _fmt_ctx *ctx = state->ctx;
+    if (!ctx->fct) {
+        ctx->idx += len;
+        return;
+    }
+    if (!ctx->write) {
+        for (size_t i = 0; i < len; i++) // byte-wise output
+            fmt_state_putchar(state, buf[i]);
+        return;
+    }
+#if PICO_PRINTF_SUPPORT_YIELD
+    // Split the chunk so that we yield at the same points that
+    // byte-wise output would.
+    while (_yield_every && len >= ctx->yield_countdown) {
+        size_t n = ctx->yield_countdown;
+        write(buf, n, ctx->write_arg);
+        ctx->idx += n;
+        buf += n;
+        len -= n;
+        ctx->yield_countdown = _yield_every;
+        _yield_fn();
+    }
+    if (_yield_every)
+        ctx->yield_countdown -= len;
+#endif
+    if (len)
+        write(buf, len, ctx->write_arg);
+    ctx->idx += len;
+}
+
+void fmt_state_write(struct fmt_state *state, const char *buf, size_t len) {
+    _out_bulk(state, state->ctx->write, buf, len);
+}
+
+// Output `len` characters that are a part of the format string or of
+// an argument, and so stay where they are until the printf returns.
+static inline void _out_ref(struct fmt_state *state, const char *buf, size_t len) {
+    _out_bulk(state, state->ctx->ref ? state->ctx->ref : state->ctx->write, buf, len);
+}
+
 inline size_t fmt_state_len(struct fmt_state *state) {
     return state->ctx->idx;
 }
@@ -117,13 +200,56 @@ inline size_t fmt_state_len(struct fmt_state *state) {
 #define array_len(ary) (sizeof(ary) / sizeof(ary[0]))
 #define max(a, b)      ((a) > (b) ? (a) : (b))
 
-// internal secure strlen
+// Output `n` copies of `c`; in chunks, if there is a bulk output function.
+static void _out_pad(struct fmt_state *state, char c, size_t n) {
+    if (!state->ctx->fct) {
+        state->ctx->idx += n;
+        return;
+    }
+    if (!state->ctx->write) {
+        while (n--) // byte-wise padding
+            fmt_state_putchar(state, c);
+        return;
+    }
+    char buf[16];
+    for (size_t i = 0; i < sizeof(buf); i++)
+        buf[i] = c;
+    while (n) { // chunked padding
+        size_t chunk = n < sizeof(buf) ? n : sizeof(buf);
+        fmt_state_write(state, buf, chunk);
+        n -= chunk;
+    }
+}
+
+typedef uint32_t _fmt_word __attribute__((may_alias));
+
+// internal secure strlen; word-at-a-time once `str` is aligned
 // \return The length of the string (excluding the terminating 0) limited by 'maxsize'
-static inline unsigned int _strnlen_s(const char *str, size_t maxsize) {
-    const char *s;
-    for (s = str; *s && maxsize--; ++s)
-        ;
-    return (unsigned int) (s - str);
+//
+// Reading a whole aligned word may read past the terminating 0, but
+// never past the end of the page (or the MPU region) that the 0 is in;
+// tell ASan that this is intentional.
+__attribute__((no_sanitize_address)) static inline size_t _strnlen_s(const char *str, size_t maxsize) {
+    const char *s = str;
+    while (maxsize && ((uintptr_t) s % sizeof(_fmt_word))) { // unaligned head
+        if (!*s)
+            return (size_t) (s - str);
+        s++;
+        maxsize--;
+    }
+    while (maxsize >= sizeof(_fmt_word)) { // aligned words
+        _fmt_word w = *(const _fmt_word *) s;
+        // has a 0 byte?
+        if ((w - 0x01010101U) & ~w & 0x80808080U)
+            break;
+        s += sizeof(_fmt_word);
+        maxsize -= sizeof(_fmt_word);
+    }
+    while (maxsize && *s) { // tail
+        s++;
+        maxsize--;
+    }
+    return (size_t) (s - str);
 }
 
 // The `~` operator, but without C promoting it to an int, which would
@@ -207,6 +333,11 @@ static void _ntoa_intro(struct fmt_state *state, unsigned base, unsigned ndigits
         // ignore '0' flag when precision is given
         state->flags &= flipflag(FMT_FLAG_ZEROPAD);
 
+    // always have at least one '0' digit, unless precision told us otherwise
+    const bool zero_digit = sign == 0 && !(state->flags & FMT_FLAG_PRECISION);
+    if (zero_digit)
+        ndigits = 1;
+
     // emit leading spaces
     if (state->width &&
         !(state->flags & FMT_FLAG_LEFT) &&
@@ -251,10 +382,9 @@ static void _ntoa_intro(struct fmt_state *state, unsigned base, unsigned ndigits
                (state->flags & FMT_FLAG_ZEROPAD)) {
         for (unsigned i = ndigits + nextra; i < state->width; i++)
             fmt_state_putchar(state, '0');
-    } else if (sign == 0) {
-        // always have at least one '0' digit, unless precision told us otherwise
-        fmt_state_putchar(state, '0');
     }
+    if (zero_digit)
+        fmt_state_putchar(state, '0');
 }
 
 static void _ntoa_outro(struct fmt_state *state, size_t start_idx) {
@@ -593,18 +723,24 @@ static void _etoa(struct fmt_state *state, double value, bool adapt_exp) {
 
 // main ///////////////////////////////////////////////////////////////////////
 
-inline static void _put_quoted_byte(struct fmt_state *state, unsigned char c) {
-    fmt_state_putchar(state, '\'');
+// Put `c`, backslash-escaped if it is the `quote` character, a
+// backslash, or not printable ASCII.
+inline static void _put_escaped_byte(struct fmt_state *state, unsigned char c, char quote) {
     if (' ' <= c && c <= '~') {
-        if (c == '\'' || c == '\\')
+        if (c == (unsigned char) quote || c == '\\')
             fmt_state_putchar(state, '\\');
         fmt_state_putchar(state, (char) c);
     } else {
         fmt_state_putchar(state, '\\');
         fmt_state_putchar(state, 'x');
-        fmt_state_putchar(state, (c >> 4) & 0xF);
-        fmt_state_putchar(state, (c >> 0) & 0xF);
+        fmt_state_putchar(state, "0123456789abcdef"[(c >> 4) & 0xF]);
+        fmt_state_putchar(state, "0123456789abcdef"[(c >> 0) & 0xF]);
     }
+}
+
+inline static void _put_quoted_byte(struct fmt_state *state, unsigned char c) {
+    fmt_state_putchar(state, '\'');
+    _put_escaped_byte(state, c, '\'');
     fmt_state_putchar(state, '\'');
 }
 
@@ -617,6 +753,32 @@ static void conv_char(struct fmt_state *state);
 static void conv_str(struct fmt_state *state);
 static void conv_ptr(struct fmt_state *state);
 static void conv_pct(struct fmt_state *state);
+#if PICO_PRINTF_SUPPORT_SLICE
+static void conv_slice(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_HEXDUMP
+static void conv_hexdump(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_QUOTE
+static void conv_quote(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_BASE64
+static void conv_base64(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_NETADDR
+static void conv_ipaddr(struct fmt_state *state);
+static void conv_macaddr(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_UNITS
+static void conv_size(struct fmt_state *state);
+static void conv_duration(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_STRUCT
+static void conv_struct(struct fmt_state *state);
+#endif
+#if PICO_PRINTF_SUPPORT_VALUE
+static void conv_value(struct fmt_state *state);
+#endif
 
 static fmt_specifier_t specifier_table[0x7F] = {
     ['d'] = conv_sint,
@@ -643,6 +805,33 @@ static fmt_specifier_t specifier_table[0x7F] = {
     ['s'] = conv_str,
     ['p'] = conv_ptr,
     ['%'] = conv_pct,
+
+#if PICO_PRINTF_SUPPORT_SLICE
+    ['S'] = conv_slice,
+#endif
+#if PICO_PRINTF_SUPPORT_HEXDUMP
+    ['H'] = conv_hexdump,
+#endif
+#if PICO_PRINTF_SUPPORT_QUOTE
+    ['q'] = conv_quote,
+#endif
+#if PICO_PRINTF_SUPPORT_BASE64
+    ['r'] = conv_base64,
+#endif
+#if PICO_PRINTF_SUPPORT_NETADDR
+    ['I'] = conv_ipaddr,
+    ['M'] = conv_macaddr,
+#endif
+#if PICO_PRINTF_SUPPORT_UNITS
+    ['K'] = conv_size,
+    ['T'] = conv_duration,
+#endif
+#if PICO_PRINTF_SUPPORT_STRUCT
+    ['R'] = conv_struct,
+#endif
+#if PICO_PRINTF_SUPPORT_VALUE
+    ['v'] = conv_value,
+#endif
 };
 
 void fmt_install(char character, fmt_specifier_t fn) {
@@ -653,131 +842,212 @@ void fmt_install(char character, fmt_specifier_t fn) {
         specifier_table[idx] = fn;
 }
 
-static void _vfctprintf(struct _fmt_ctx *ctx, const char *format, va_list *va_save) {
-    struct fmt_state _state = {
-        .args = va_save,
-        .ctx = ctx,
+#if PICO_PRINTF_MAX_WIDTH || PICO_PRINTF_MAX_PRECISION
+static const char *_exceeded(struct fmt_state *state) {
+#if PICO_PRINTF_MAX_WIDTH
+    if (state->width > PICO_PRINTF_MAX_WIDTH)
+        return "%!(exceeded PICO_PRINTF_MAX_WIDTH)";
+#endif
+#if PICO_PRINTF_MAX_PRECISION
+    if ((state->flags & FMT_FLAG_PRECISION) && state->precision > PICO_PRINTF_MAX_PRECISION)
+        return "%!(exceeded PICO_PRINTF_MAX_PRECISION)";
+#endif
+    return NULL;
+}
+
+// Run the conversion without a width or precision, and without
+// output, just so that it consumes its arguments.
+static void _skip_conversion(struct fmt_state *state, fmt_specifier_t fn) {
+    struct _fmt_ctx *ctx = state->ctx;
+    struct _fmt_ctx skip_ctx = {
+        .fct = NULL,
+        .idx = ctx->idx,
     };
-    struct fmt_state *state = &_state;
+    state->ctx = &skip_ctx;
+    state->width = 0U;
+    state->precision = 0U;
+    fn(state);
+    state->ctx = ctx;
+}
+#endif
 
-    while (*format) {
-        // format specifier?  %[flags][width][.precision][size]specifier
-        if (*format != '%') {
-            // no
-            fmt_state_putchar(state, *format);
-            format++;
-            continue;
-        } else {
-            // yes, evaluate it
+// Evaluate the size field, returning the rest of the format string.
+static const char *_parse_size(struct fmt_state *state, const char *format) {
+    state->size = FMT_SIZE_DEFAULT;
+    switch (*format) {
+        case 'l':
+            state->size = FMT_SIZE_LONG;
             format++;
-        }
-
-        // evaluate flags
-        state->flags = 0U;
-        for (;;) {
-            switch (*format) {
-                case '0':
-                    state->flags |= FMT_FLAG_ZEROPAD;
-                    format++;
-                    break;
-                case '-':
-                    state->flags |= FMT_FLAG_LEFT;
-                    format++;
-                    break;
-                case '+':
-                    state->flags |= FMT_FLAG_PLUS;
-                    format++;
-                    break;
-                case ' ':
-                    state->flags |= FMT_FLAG_SPACE;
-                    format++;
-                    break;
-                case '#':
-                    state->flags |= FMT_FLAG_HASH;
-                    format++;
-                    break;
-                default:
-                    goto no_more_flags;
-            }
-        }
-    no_more_flags:
-
-        // evaluate width field
-        state->width = 0U;
-        if (_is_digit(*format)) {
-            state->width = _atoi(&format);
-        } else if (*format == '*') {
-            const int w = va_arg(*state->args, int);
-            if (w < 0) {
-                state->flags |= FMT_FLAG_LEFT; // reverse padding
-                state->width = (unsigned int) -w;
-            } else {
-                state->width = (unsigned int) w;
+            if (*format == 'l') {
+                state->size = FMT_SIZE_LONG_LONG;
+                format++;
             }
+            break;
+        case 'h':
+            state->size = FMT_SIZE_SHORT;
             format++;
-        }
-
-        // evaluate precision field
-        state->precision = 0U;
-        if (*format == '.') {
-            state->flags |= FMT_FLAG_PRECISION;
-            format++;
-            if (_is_digit(*format)) {
-                state->precision = _atoi(&format);
-            } else if (*format == '*') {
-                const int prec = (int) va_arg(*state->args, int);
-                state->precision = prec > 0 ? (unsigned int) prec : 0U;
+            if (*format == 'h') {
+                state->size = FMT_SIZE_CHAR;
                 format++;
             }
-        }
+            break;
+#if PICO_PRINTF_SUPPORT_PTRDIFF_T
+        case 't':
+            state->size = (sizeof(ptrdiff_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
+            format++;
+            break;
+#endif
+        case 'j':
+            state->size = (sizeof(intmax_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
+            format++;
+            break;
+        case 'z':
+            state->size = (sizeof(size_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
+            format++;
+            break;
+        default:
+            break;
+    }
+    return format;
+}
 
-        // evaluate size field
-        state->size = FMT_SIZE_DEFAULT;
+// Run the conversion that `state` describes.
+static void _convert(struct fmt_state *state) {
+    if ((unsigned int) state->specifier < array_len(specifier_table) &&
+        specifier_table[(unsigned int) state->specifier]) {
+#if PICO_PRINTF_MAX_WIDTH || PICO_PRINTF_MAX_PRECISION
+        const char *exceeded = _exceeded(state);
+        if (exceeded) {
+            _skip_conversion(state, specifier_table[(unsigned int) state->specifier]);
+            fmt_state_puts(state, exceeded);
+        } else
+#endif
+            specifier_table[(unsigned int) state->specifier](state);
+    } else {
+        fmt_state_puts(state, "%!(unknown specifier=");
+        _put_quoted_byte(state, (unsigned char) state->specifier);
+        fmt_state_putchar(state, ')');
+    }
+#if PICO_PRINTF_SUPPORT_YIELD
+    if (_yield_fn && !_yield_every && state->ctx->fct)
+        _yield_fn();
+#endif
+}
+
+void fmt_state_convert(struct fmt_state *state, char specifier, const struct fmt_arg *argv) {
+    struct fmt_state substate = *state;
+    substate.specifier = specifier;
+    substate.argv = argv;
+    // `argv` may point at the caller's locals, which won't outlive it.
+    const fmt_write_t ref = state->ctx->ref;
+    state->ctx->ref = NULL;
+    _convert(&substate);
+    state->ctx->ref = ref;
+}
+
+// Evaluate the conversion after a '%', and run it, returning the rest
+// of the format string.
+static const char *_printf_conversion(struct fmt_state *state, const char *format) {
+    // evaluate flags
+    state->flags = 0U;
+    for (;;) {
         switch (*format) {
-            case 'l':
-                state->size = FMT_SIZE_LONG;
+            case '0':
+                state->flags |= FMT_FLAG_ZEROPAD;
                 format++;
-                if (*format == 'l') {
-                    state->size = FMT_SIZE_LONG_LONG;
-                    format++;
-                }
                 break;
-            case 'h':
-                state->size = FMT_SIZE_SHORT;
+            case '-':
+                state->flags |= FMT_FLAG_LEFT;
                 format++;
-                if (*format == 'h') {
-                    state->size = FMT_SIZE_CHAR;
-                    format++;
-                }
                 break;
-#if PICO_PRINTF_SUPPORT_PTRDIFF_T
-            case 't':
-                state->size = (sizeof(ptrdiff_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
+            case '+':
+                state->flags |= FMT_FLAG_PLUS;
                 format++;
                 break;
-#endif
-            case 'j':
-                state->size = (sizeof(intmax_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
+            case ' ':
+                state->flags |= FMT_FLAG_SPACE;
                 format++;
                 break;
-            case 'z':
-                state->size = (sizeof(size_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
+            case '#':
+                state->flags |= FMT_FLAG_HASH;
                 format++;
                 break;
             default:
-                break;
+                goto no_more_flags;
+        }
+    }
+no_more_flags:
+
+    // evaluate width field
+    state->width = 0U;
+    if (_is_digit(*format)) {
+        state->width = _atoi(&format);
+    } else if (*format == '*') {
+        const int w = fmt_state_arg_int(state);
+        if (w < 0) {
+            state->flags |= FMT_FLAG_LEFT; // reverse padding
+            state->width = (unsigned int) -w;
+        } else {
+            state->width = (unsigned int) w;
         }
+        format++;
+    }
 
-        // evaluate specifier
-        state->specifier = *format;
+    // evaluate precision field
+    state->precision = 0U;
+    if (*format == '.') {
+        state->flags |= FMT_FLAG_PRECISION;
         format++;
-        if ((unsigned int) state->specifier < array_len(specifier_table) &&
-            specifier_table[(unsigned int) state->specifier]) {
-            specifier_table[(unsigned int) state->specifier](state);
+        if (_is_digit(*format)) {
+            state->precision = _atoi(&format);
+        } else if (*format == '*') {
+            const int prec = fmt_state_arg_int(state);
+            if (prec < 0)
+                // a negative precision is taken as if the precision were omitted
+                state->flags &= flipflag(FMT_FLAG_PRECISION);
+            else
+                state->precision = (unsigned int) prec;
+            format++;
+        }
+    }
+
+    // evaluate size field
+    format = _parse_size(state, format);
+
+    // evaluate specifier
+    state->specifier = *format;
+    if (*format)
+        format++;
+    _convert(state);
+    return format;
+}
+
+static void _vfctprintf(struct _fmt_ctx *ctx, const char *format, va_list *va_save, const struct fmt_arg *argv) {
+    struct fmt_state _state = {
+        .args = va_save,
+        .argv = argv,
+        .ctx = ctx,
+    };
+    struct fmt_state *state = &_state;
+
+    while (*format) {
+        // format specifier?  %[flags][width][.precision][size]specifier
+        if (*format != '%') {
+            // no
+            if (ctx->write) {
+                // hand over the whole run of literal text at once
+                size_t n = 1;
+                while (format[n] && format[n] != '%')
+                    n++;
+                _out_ref(state, format, n);
+                format += n;
+            } else {
+                fmt_state_putchar(state, *format);
+                format++;
+            }
         } else {
-            fmt_state_puts(state, "%!(unknown specifier=");
-            _put_quoted_byte(state, (unsigned char) state->specifier);
-            fmt_state_putchar(state, ')');
+            // yes, evaluate it
+            format = _printf_conversion(state, format + 1);
         }
     }
 }
@@ -787,56 +1057,384 @@ int fmt_vfctprintf(fmt_fct_t fct, void *arg, const char *format, va_list _va) {
         .fct = fct,
         .arg = arg,
         .idx = 0,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
     };
     va_list _va_save;
     va_copy(_va_save, _va);
-    _vfctprintf(&_ctx, format, &_va_save);
+    _vfctprintf(&_ctx, format, &_va_save, NULL);
     va_end(_va_save);
     return (int) _ctx.idx;
 }
 
+static void _out_write1(char character, void *arg) {
+    struct _fmt_ctx *ctx = arg;
+    ctx->write(&character, 1, ctx->write_arg);
+}
+
+int fmt_vwriteprintf(fmt_write_t write, void *arg, const char *format, va_list _va) {
+    struct _fmt_ctx _ctx = {
+        .fct = write ? _out_write1 : NULL,
+        .arg = &_ctx,
+        .idx = 0,
+        .write = write,
+        .write_arg = arg,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
+    };
+    va_list _va_save;
+    va_copy(_va_save, _va);
+    _vfctprintf(&_ctx, format, &_va_save, NULL);
+    va_end(_va_save);
+    return (int) _ctx.idx;
+}
+
+int fmt_vwriterefprintf(fmt_write_t write, fmt_write_t ref, void *arg, const char *format, va_list _va) {
+    struct _fmt_ctx _ctx = {
+        .fct = write ? _out_write1 : NULL,
+        .arg = &_ctx,
+        .idx = 0,
+        .write = write,
+        .write_arg = arg,
+        .ref = ref,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
+    };
+    va_list _va_save;
+    va_copy(_va_save, _va);
+    _vfctprintf(&_ctx, format, &_va_save, NULL);
+    va_end(_va_save);
+    return (int) _ctx.idx;
+}
+
+int fmt_writeprintf_argv(fmt_write_t write, void *arg, const char *format, const struct fmt_arg *argv) {
+    struct _fmt_ctx _ctx = {
+        .fct = write ? _out_write1 : NULL,
+        .arg = &_ctx,
+        .idx = 0,
+        .write = write,
+        .write_arg = arg,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
+    };
+    _vfctprintf(&_ctx, format, NULL, argv);
+    return (int) _ctx.idx;
+}
+
 void fmt_state_vprintf(struct fmt_state *state, const char *format, va_list _va) {
     va_list _va_save;
     va_copy(_va_save, _va);
-    _vfctprintf(state->ctx, format, &_va_save);
+    // The format and arguments may be the caller's locals, which won't
+    // outlive it.
+    const fmt_write_t ref = state->ctx->ref;
+    state->ctx->ref = NULL;
+    _vfctprintf(state->ctx, format, &_va_save, NULL);
+    state->ctx->ref = ref;
     va_end(_va_save);
 }
 
+void fmt_stream_init(struct fmt_stream *s, const char *format, va_list va) {
+    s->format = format;
+    va_copy(s->va, va);
+    s->skip = 0;
+}
+
+struct _fmt_stream_buf {
+    struct _fmt_ctx *ctx;
+    char *buf;
+    size_t len;
+    size_t n;    // how much of buf has been filled
+    size_t skip; // how much more output to drop before filling buf
+};
+
+static void _stream_write(const char *p, size_t l, void *arg) {
+    struct _fmt_stream_buf *b = arg;
+    const size_t skip = b->skip < l ? b->skip : l;
+    b->skip -= skip;
+    p += skip;
+    l -= skip;
+    if (l > b->len - b->n)
+        l = b->len - b->n;
+    for (size_t i = 0; i < l; i++)
+        b->buf[b->n + i] = p[i];
+    b->n += l;
+    if (b->n == b->len)
+        // Full; only count the rest of the conversion.
+        b->ctx->fct = NULL;
+}
+
+// Read up to `len` characters of the stream in to `buf`; or if `buf`
+// is NULL, skip over them, without outputting them.
+static size_t _stream_advance(struct fmt_stream *s, char *buf, size_t len) {
+    struct _fmt_ctx _ctx = {
+        .fct = buf ? _out_write1 : NULL,
+        .arg = &_ctx,
+        .write = _stream_write,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
+    };
+    struct _fmt_stream_buf b = {
+        .ctx = &_ctx,
+        .buf = buf,
+        .len = len,
+    };
+    _ctx.write_arg = &b;
+
+    size_t n = 0;
+    while (*s->format && n < len) {
+        // a run of literal text, up to the next conversion or as much
+        // of it as fits
+        if (*s->format != '%') {
+            size_t l = 1;
+            while (l < len - n && s->format[l] && s->format[l] != '%')
+                l++;
+            if (buf)
+                memcpy(&buf[n], s->format, l);
+            n += l;
+            s->format += l;
+            continue;
+        }
+
+        // a conversion, which may have been partly read already
+        va_list va;
+        va_copy(va, s->va);
+        struct fmt_state state = {
+            .args = &va,
+            .ctx = &_ctx,
+        };
+        const size_t start_idx = _ctx.idx;
+        b.n = n;
+        b.skip = s->skip;
+        const char *rest = _printf_conversion(&state, s->format + 1);
+        const size_t left = _ctx.idx - start_idx - s->skip;
+        if (left > len - n) {
+            // it didn't all fit; go again next time
+            s->skip += len - n;
+            n = len;
+            va_end(va);
+            break;
+        }
+        n += left;
+        s->format = rest;
+        s->skip = 0;
+        va_end(s->va);
+        va_copy(s->va, va);
+        va_end(va);
+    }
+    return n;
+}
+
+size_t fmt_stream_read(struct fmt_stream *s, char *buf, size_t len) {
+    return _stream_advance(s, buf, len);
+}
+
+size_t fmt_stream_skip(struct fmt_stream *s, size_t len) {
+    return _stream_advance(s, NULL, len);
+}
+
+size_t fmt_vwindowprintf(char *buf, size_t offset, size_t len, const char *format, va_list va) {
+    struct fmt_stream s;
+    fmt_stream_init(&s, format, va);
+    size_t n = 0;
+    if (fmt_stream_skip(&s, offset) == offset)
+        n = fmt_stream_read(&s, buf, len);
+    fmt_stream_end(&s);
+    return n;
+}
+
+void fmt_stream_end(struct fmt_stream *s) {
+    va_end(s->va);
+}
+
+#if PICO_PRINTF_SUPPORT_BRACES
+// The same as _vfctprintf(), but parsing `{}` replacement fields.
+// These don't have a `*` width or precision, so each field reads its
+// arguments (if any) in the conversion itself; `types` (if not NULL)
+// is indexed by how far through `argv` that conversion starts.
+static void _vfctformat(struct _fmt_ctx *ctx, const char *format, va_list *va_save, const struct fmt_arg *argv, const char *const *types) {
+    struct fmt_state _state = {
+        .args = va_save,
+        .argv = argv,
+        .ctx = ctx,
+    };
+    struct fmt_state *state = &_state;
+
+    while (*format) {
+        // replacement field?  {[:[[fill]align][sign][#][0][width][.precision][size][type]]}
+        if (*format != '{' && *format != '}') {
+            if (ctx->write) {
+                // hand over the whole run of literal text at once
+                size_t n = 1;
+                while (format[n] && format[n] != '{' && format[n] != '}')
+                    n++;
+                _out_ref(state, format, n);
+                format += n;
+            } else {
+                fmt_state_putchar(state, *format);
+                format++;
+            }
+            continue;
+        }
+        if (format[1] == format[0]) {
+            // "{{" or "}}"
+            fmt_state_putchar(state, *format);
+            format += 2;
+            continue;
+        }
+        if (*format == '}')
+            goto bad_field;
+        format++;
+
+        state->flags = 0U;
+        state->width = 0U;
+        state->precision = 0U;
+        state->size = FMT_SIZE_DEFAULT;
+        state->specifier = '\0';
+        bool sized = false;
+        bool aligned = false;
+        if (*format == ':') {
+            format++;
+            // fill and align; the only fill is the default ' ', and
+            // there is no '^' centering
+            if (*format == ' ' && (format[1] == '<' || format[1] == '>'))
+                format++;
+            if (*format == '<' || *format == '>') {
+                if (*format == '<')
+                    state->flags |= FMT_FLAG_LEFT;
+                aligned = true;
+                format++;
+            }
+            // sign
+            if (*format == '+' || *format == ' ' || *format == '-') {
+                if (*format == '+')
+                    state->flags |= FMT_FLAG_PLUS;
+                else if (*format == ' ')
+                    state->flags |= FMT_FLAG_SPACE;
+                format++;
+            }
+            if (*format == '#') {
+                state->flags |= FMT_FLAG_HASH;
+                format++;
+            }
+            if (*format == '0') {
+                state->flags |= FMT_FLAG_ZEROPAD;
+                format++;
+            }
+            if (_is_digit(*format))
+                state->width = _atoi(&format);
+            if (*format == '.') {
+                state->flags |= FMT_FLAG_PRECISION;
+                format++;
+                state->precision = _atoi(&format);
+            }
+            const char *size = format;
+            format = _parse_size(state, format);
+            sized = format != size;
+            if (*format && *format != '}')
+                state->specifier = *(format++);
+        }
+        if (*format != '}')
+            goto bad_field;
+        format++;
+
+        // fill in what the field left out from the argument's type
+        if (types) {
+            const enum fmt_size size = state->size;
+            const char *type = _parse_size(state, types[state->argv - argv]);
+            if (sized)
+                state->size = size;
+            if (!state->specifier)
+                state->specifier = *type;
+        }
+        if (!state->specifier)
+            goto bad_field;
+        // as in std::format, strings and characters default to the left
+        if (!aligned && (state->specifier == 's' || state->specifier == 'c'))
+            state->flags |= FMT_FLAG_LEFT;
+        _convert(state);
+    }
+    return;
+
+bad_field:
+    // The rest of the arguments can't be lined up with the rest of the
+    // fields, so don't try.
+    fmt_state_puts(state, "%!(bad replacement field)");
+}
+
+int fmt_vwriteformat(fmt_write_t write, void *arg, const char *format, va_list _va) {
+    struct _fmt_ctx _ctx = {
+        .fct = write ? _out_write1 : NULL,
+        .arg = &_ctx,
+        .idx = 0,
+        .write = write,
+        .write_arg = arg,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
+    };
+    va_list _va_save;
+    va_copy(_va_save, _va);
+    _vfctformat(&_ctx, format, &_va_save, NULL, NULL);
+    va_end(_va_save);
+    return (int) _ctx.idx;
+}
+
+int fmt_writeformat_argv(fmt_write_t write, void *arg, const char *format, const struct fmt_arg *argv, const char *const *types) {
+    struct _fmt_ctx _ctx = {
+        .fct = write ? _out_write1 : NULL,
+        .arg = &_ctx,
+        .idx = 0,
+        .write = write,
+        .write_arg = arg,
+#if PICO_PRINTF_SUPPORT_YIELD
+        .yield_countdown = _yield_every,
+#endif
+    };
+    _vfctformat(&_ctx, format, NULL, argv, types);
+    return (int) _ctx.idx;
+}
+#endif
+
 static void conv_sint(struct fmt_state *state) {
     const unsigned int base = 10;
     switch (state->size) {
         case FMT_SIZE_LONG_LONG:
 #if PICO_PRINTF_SUPPORT_LONG_LONG
         {
-            const long long value = va_arg(*state->args, long long);
-            _ntoall(state, (unsigned long long) (value > 0 ? value : 0 - value), value < 0, base);
+            const long long value = fmt_state_arg_llong(state);
+            _ntoall(state, value > 0 ? (unsigned long long) value : 0U - (unsigned long long) value, value < 0, base);
             break;
         }
 #else
             // fall through
 #endif
         case FMT_SIZE_LONG: {
-            const long value = va_arg(*state->args, long);
-            _ntoal(state, (unsigned long) (value > 0 ? value : 0 - value), value < 0, base);
+            const long value = fmt_state_arg_long(state);
+            _ntoal(state, value > 0 ? (unsigned long) value : 0U - (unsigned long) value, value < 0, base);
             break;
         }
         case FMT_SIZE_DEFAULT: {
-            const int value = va_arg(*state->args, int);
-            _ntoa(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
+            const int value = fmt_state_arg_int(state);
+            _ntoa(state, value > 0 ? (unsigned int) value : 0U - (unsigned int) value, value < 0, base);
             break;
         }
         case FMT_SIZE_SHORT: {
             // 'short' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state->args, int), but then truncate it with casting.
-            const int value = (short int) va_arg(*state->args, int);
-            _ntoa(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
+            // with fmt_state_arg_int(state), but then truncate it with casting.
+            const int value = (short int) fmt_state_arg_int(state);
+            _ntoa(state, value > 0 ? (unsigned int) value : 0U - (unsigned int) value, value < 0, base);
             break;
         }
         case FMT_SIZE_CHAR: {
             // 'char' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state->args, int), but then truncate it with casting.
-            const int value = (char) va_arg(*state->args, int);
-            _ntoa(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
+            // with fmt_state_arg_int(state), but then truncate it with casting.
+            const int value = (char) fmt_state_arg_int(state);
+            _ntoa(state, value > 0 ? (unsigned int) value : 0U - (unsigned int) value, value < 0, base);
             break;
         }
     }
@@ -866,33 +1464,33 @@ static void conv_uint(struct fmt_state *state) {
     switch (state->size) {
         case FMT_SIZE_LONG_LONG:
 #if PICO_PRINTF_SUPPORT_LONG_LONG
-            _ntoall(state, va_arg(*state->args, unsigned long long), false, base);
+            _ntoall(state, fmt_state_arg_ullong(state), false, base);
             break;
 #else
             // fall through
 #endif
         case FMT_SIZE_LONG:
-            _ntoal(state, va_arg(*state->args, unsigned long), false, base);
+            _ntoal(state, fmt_state_arg_ulong(state), false, base);
             break;
         case FMT_SIZE_DEFAULT:
-            _ntoa(state, va_arg(*state->args, unsigned int), false, base);
+            _ntoa(state, fmt_state_arg_uint(state), false, base);
             break;
         case FMT_SIZE_SHORT:
             // 'short' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state->args, unsigned int), but then truncate it with casting.
-            _ntoa(state, (unsigned short int) va_arg(*state->args, unsigned int), false, base);
+            // with fmt_state_arg_uint(state), but then truncate it with casting.
+            _ntoa(state, (unsigned short int) fmt_state_arg_uint(state), false, base);
             break;
         case FMT_SIZE_CHAR:
             // 'char' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state->args, unsigned int), but then truncate it with casting.
-            _ntoa(state, (unsigned char) va_arg(*state->args, unsigned int), false, base);
+            // with fmt_state_arg_uint(state), but then truncate it with casting.
+            _ntoa(state, (unsigned char) fmt_state_arg_uint(state), false, base);
             break;
     }
 }
 
 #if PICO_PRINTF_SUPPORT_FLOAT
 static void conv_double(struct fmt_state *state) {
-    double value = va_arg(*state->args, double);
+    double value = fmt_state_arg_double(state);
     switch (state->specifier) {
         case 'f':
         case 'F':
@@ -919,46 +1517,118 @@ static void conv_double(struct fmt_state *state) {
 #endif
 
 static void conv_char(struct fmt_state *state) {
-    unsigned int l = 1U;
+    const size_t pad = state->width > 1U ? state->width - 1U : 0U;
     // pre padding
-    if (!(state->flags & FMT_FLAG_LEFT)) {
-        while (l++ < state->width) {
-            fmt_state_putchar(state, ' ');
-        }
-    }
+    if (!(state->flags & FMT_FLAG_LEFT))
+        _out_pad(state, ' ', pad);
     // char output
-    fmt_state_putchar(state, (char) va_arg(*state->args, int));
+    fmt_state_putchar(state, (char) fmt_state_arg_int(state));
     // post padding
-    if (state->flags & FMT_FLAG_LEFT) {
-        while (l++ < state->width) {
-            fmt_state_putchar(state, ' ');
-        }
-    }
+    if (state->flags & FMT_FLAG_LEFT)
+        _out_pad(state, ' ', pad);
 }
 
-static void conv_str(struct fmt_state *state) {
-    const char *p = va_arg(*state->args, char *);
-    unsigned int l = _strnlen_s(p, state->precision ? state->precision : (size_t) -1);
-    // pre padding
-    if (state->flags & FMT_FLAG_PRECISION) {
-        l = (l < state->precision ? l : state->precision);
+#if PICO_PRINTF_SUPPORT_UTF8
+// \return The number of UTF-8 code points in the `l` bytes at `p` (that
+// is, the number of bytes that are not continuation bytes);
+// word-at-a-time once `p` is aligned, so that ASCII is cheap.
+static inline size_t _utf8_len(const char *p, size_t l) {
+    size_t cont = 0;
+    const char *s = p;
+    while (l && ((uintptr_t) s % sizeof(_fmt_word))) { // unaligned head
+        cont += ((unsigned char) *s & 0xC0U) == 0x80U;
+        s++;
+        l--;
     }
-    if (!(state->flags & FMT_FLAG_LEFT)) {
-        while (l++ < state->width) {
-            fmt_state_putchar(state, ' ');
+    while (l >= sizeof(_fmt_word)) { // aligned words
+        const _fmt_word w = *(const _fmt_word *) s;
+        // has a non-ASCII byte?
+        if (w & 0x80808080U)
+            for (size_t i = 0; i < sizeof(_fmt_word); i++)
+                cont += ((unsigned char) s[i] & 0xC0U) == 0x80U;
+        s += sizeof(_fmt_word);
+        l -= sizeof(_fmt_word);
+    }
+    while (l) { // tail
+        cont += ((unsigned char) *s & 0xC0U) == 0x80U;
+        s++;
+        l--;
+    }
+    return (size_t) (s - p) - cont;
+}
+
+// \return `l`, backed up so that it does not split the last UTF-8
+// sequence in the `l` bytes at `p`; which are all that it looks at, as
+// p[l] may be past the end of the string.
+static inline size_t _utf8_boundary(const char *p, size_t l) {
+    size_t i = l;
+    while (i && l - i < 4) {
+        i--;
+        const unsigned char c = (unsigned char) p[i];
+        if ((c & 0xC0U) != 0x80U) {
+            // p[i] is the lead byte; does all of its sequence fit?
+            const size_t n = c < 0x80U ? 1U : 2U + (c >= 0xE0U) + (c >= 0xF0U);
+            return i + n <= l ? l : i;
         }
     }
+    // not UTF-8; leave it be
+    return l;
+}
+#endif
+
+// Output the `l` bytes at `p`, padded to the width.  `in_place` is
+// whether `p` is the caller's memory (a `%s` argument) rather than a
+// temporary buffer.
+static void _out_strn(struct fmt_state *state, const char *p, size_t l, bool in_place) {
+    size_t cols = l;
+#if PICO_PRINTF_SUPPORT_UTF8
+    if ((state->flags & FMT_FLAG_HASH) && state->width)
+        cols = _utf8_len(p, l);
+#endif
+    const size_t pad = cols < state->width ? state->width - cols : 0U;
+    // pre padding
+    if (!(state->flags & FMT_FLAG_LEFT))
+        _out_pad(state, ' ', pad);
     // string output
-    while ((*p != 0) && (!(state->flags & FMT_FLAG_PRECISION) || state->precision--)) {
-        fmt_state_putchar(state, *(p++));
-    }
+    if (in_place)
+        _out_ref(state, p, l);
+    else
+        fmt_state_write(state, p, l);
     // post padding
-    if (state->flags & FMT_FLAG_LEFT) {
-        while (l++ < state->width) {
-            fmt_state_putchar(state, ' ');
-        }
+    if (state->flags & FMT_FLAG_LEFT)
+        _out_pad(state, ' ', pad);
+}
+
+static inline void _out_str(struct fmt_state *state, const char *p, size_t l) {
+    _out_strn(state, p, l, false);
+}
+
+static void conv_str(struct fmt_state *state) {
+    const char *p = fmt_state_arg_ptr(state);
+    size_t l = _strnlen_s(p, (state->flags & FMT_FLAG_PRECISION) ? state->precision : (size_t) -1);
+#if PICO_PRINTF_SUPPORT_UTF8
+    if ((state->flags & FMT_FLAG_HASH) && (state->flags & FMT_FLAG_PRECISION) && l == state->precision)
+        l = _utf8_boundary(p, l);
+#endif
+    _out_strn(state, p, l, true);
+}
+
+#if PICO_PRINTF_SUPPORT_SLICE
+// %S takes a pointer and a size_t length, and never reads past the
+// length (nor looks for a NUL); a precision further limits the length.
+static void conv_slice(struct fmt_state *state) {
+    const char *p = fmt_state_arg_ptr(state);
+    size_t l = fmt_state_arg_size(state);
+    if ((state->flags & FMT_FLAG_PRECISION) && state->precision < l) {
+        l = state->precision;
+#if PICO_PRINTF_SUPPORT_UTF8
+        if (state->flags & FMT_FLAG_HASH)
+            l = _utf8_boundary(p, l);
+#endif
     }
+    _out_strn(state, p, l, true);
 }
+#endif
 
 static void conv_ptr(struct fmt_state *state) {
     state->width = sizeof(void *) * 2U;
@@ -969,17 +1639,681 @@ static void conv_ptr(struct fmt_state *state) {
                    sizeof(uintptr_t) == sizeof(long) ||
                    sizeof(uintptr_t) == sizeof(long long));
     if (sizeof(uintptr_t) == sizeof(int))
-        _ntoa(state, (unsigned int) (uintptr_t) va_arg(*state->args, void *), false, 16U);
+        _ntoa(state, (unsigned int) (uintptr_t) fmt_state_arg_ptr(state), false, 16U);
     else if (sizeof(uintptr_t) == sizeof(long))
-        _ntoal(state, (unsigned long) (uintptr_t) va_arg(*state->args, void *), false, 16U);
+        _ntoal(state, (unsigned long) (uintptr_t) fmt_state_arg_ptr(state), false, 16U);
     else if (sizeof(uintptr_t) == sizeof(long long))
 #if PICO_PRINTF_SUPPORT_LONG_LONG
-        _ntoall(state, (unsigned long long) (uintptr_t) va_arg(*state->args, void *), false, 16U);
+        _ntoall(state, (unsigned long long) (uintptr_t) fmt_state_arg_ptr(state), false, 16U);
 #else
-        _ntoal(state, (unsigned long) (uintptr_t) va_arg(*state->args, void *), false, 16U);
+        _ntoal(state, (unsigned long) (uintptr_t) fmt_state_arg_ptr(state), false, 16U);
 #endif
 }
 
 static void conv_pct(struct fmt_state *state) {
     fmt_state_putchar(state, '%');
 }
+
+#if PICO_PRINTF_SUPPORT_HEXDUMP || PICO_PRINTF_SUPPORT_BASE64
+// A small output buffer, so that a conversion can be built a byte at
+// a time but handed to the output function in chunks.
+struct _chunkbuf {
+    char buf[32];
+    size_t n;
+};
+
+static inline void _chunk_flush(struct fmt_state *state, struct _chunkbuf *cb) {
+    fmt_state_write(state, cb->buf, cb->n);
+    cb->n = 0;
+}
+
+static inline void _chunk_putchar(struct fmt_state *state, struct _chunkbuf *cb, char c) {
+    if (cb->n == sizeof(cb->buf))
+        _chunk_flush(state, cb);
+    cb->buf[cb->n++] = c;
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_HEXDUMP
+// Emit `cols` columns of hex, of which the first `n` are the bytes at
+// `p`, and the rest are blank; with `sep` (if non-zero) between each
+// group of `group` bytes.
+static void _hexdump_bytes(struct fmt_state *state, struct _chunkbuf *cb,
+                           const unsigned char *p, size_t n, size_t cols,
+                           size_t group, char sep) {
+    for (size_t i = 0; i < cols; i++) {
+        if (sep && i && !(i % group))
+            _chunk_putchar(state, cb, sep);
+        if (i < n) {
+            _chunk_putchar(state, cb, "0123456789abcdef"[p[i] >> 4]);
+            _chunk_putchar(state, cb, "0123456789abcdef"[p[i] & 0xF]);
+        } else {
+            _chunk_putchar(state, cb, ' ');
+            _chunk_putchar(state, cb, ' ');
+        }
+    }
+}
+
+// %H takes a pointer and a size_t length, and emits the bytes as hex.
+//
+//   - The ' ' or '+' flag puts a ' ' or ':' (respectively) between
+//     groups of bytes; the precision is the group size (default 1).
+//   - Without '#', the width and '-' pad the dump as for %s.
+//   - With '#', the dump is xxd-style lines of offset, hex (grouped
+//     by 2 and separated by ' ', by default), and an ASCII sidebar;
+//     the width is the number of bytes per line (default 16).
+static void conv_hexdump(struct fmt_state *state) {
+    const unsigned char *p = fmt_state_arg_ptr(state);
+    const size_t len = fmt_state_arg_size(state);
+    const bool xxd = state->flags & FMT_FLAG_HASH;
+
+    char sep = 0;
+    if (state->flags & FMT_FLAG_PLUS)
+        sep = ':';
+    else if ((state->flags & FMT_FLAG_SPACE) || xxd)
+        sep = ' ';
+    size_t group = xxd ? 2U : 1U;
+    if ((state->flags & FMT_FLAG_PRECISION) && state->precision)
+        group = state->precision;
+
+    struct _chunkbuf cb = {.n = 0};
+    if (!xxd) {
+        const size_t l = len * 2U + (sep && len ? (len - 1U) / group : 0U);
+        const size_t pad = l < state->width ? state->width - l : 0U;
+        if (!(state->flags & FMT_FLAG_LEFT))
+            _out_pad(state, ' ', pad);
+        _hexdump_bytes(state, &cb, p, len, len, group, sep);
+        _chunk_flush(state, &cb);
+        if (state->flags & FMT_FLAG_LEFT)
+            _out_pad(state, ' ', pad);
+        return;
+    }
+
+    const size_t cols = state->width ? state->width : 16U;
+    for (size_t off = 0; off < len; off += cols) {
+        const size_t n = len - off < cols ? len - off : cols;
+        // offset
+        for (int shift = off >> 31 >> 1 ? 60 : 28; shift >= 0; shift -= 4)
+            _chunk_putchar(state, &cb, "0123456789abcdef"[(off >> shift) & 0xF]);
+        _chunk_putchar(state, &cb, ':');
+        _chunk_putchar(state, &cb, ' ');
+        // hex
+        _hexdump_bytes(state, &cb, &p[off], n, cols, group, sep);
+        // ASCII
+        _chunk_putchar(state, &cb, ' ');
+        _chunk_putchar(state, &cb, ' ');
+        for (size_t i = 0; i < n; i++)
+            _chunk_putchar(state, &cb, (' ' <= p[off + i] && p[off + i] <= '~') ? (char) p[off + i] : '.');
+        _chunk_putchar(state, &cb, '\n');
+    }
+    _chunk_flush(state, &cb);
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_QUOTE
+// \return How many bytes _put_escaped_byte() puts for `c`.
+static inline size_t _escaped_len(unsigned char c, char quote) {
+    if (' ' <= c && c <= '~')
+        return (c == (unsigned char) quote || c == '\\') ? 2U : 1U;
+    return 4U;
+}
+
+// \return The length of the prefix of the `n` bytes at `p` that %q
+// can put as-is (printable ASCII other than '"' and '\\');
+// word-at-a-time once `p` is aligned.
+static inline size_t _clean_span(const char *p, size_t n) {
+    const char *s = p;
+    while (n && ((uintptr_t) s % sizeof(_fmt_word))) { // unaligned head
+        if (_escaped_len((unsigned char) *s, '"') != 1U)
+            return (size_t) (s - p);
+        s++;
+        n--;
+    }
+    while (n >= sizeof(_fmt_word)) { // aligned words
+        const _fmt_word w = *(const _fmt_word *) s;
+        const _fmt_word q = w ^ 0x22222222U; // '"' => 0
+        const _fmt_word b = w ^ 0x5C5C5C5CU; // '\\' => 0
+        // has a byte that is < ' ', > '~', '"', or '\\'?
+        if ((((w - 0x20202020U) & ~w) | (w + 0x01010101U) | w |
+             ((q - 0x01010101U) & ~q) | ((b - 0x01010101U) & ~b)) &
+            0x80808080U)
+            break;
+        s += sizeof(_fmt_word);
+        n -= sizeof(_fmt_word);
+    }
+    while (n && _escaped_len((unsigned char) *s, '"') == 1U) { // tail
+        s++;
+        n--;
+    }
+    return (size_t) (s - p);
+}
+
+// Put the `n` bytes at `p` escaped, with the clean spans between
+// escapes put in bulk; or, if `state` is NULL, only measure them.
+// \return The escaped length.
+static size_t _out_escaped(struct fmt_state *state, const char *p, size_t n) {
+    size_t l = 0;
+    while (n) { // per escape
+        const size_t clean = _clean_span(p, n);
+        if (state)
+            fmt_state_write(state, p, clean);
+        l += clean;
+        p += clean;
+        n -= clean;
+        if (n) {
+            if (state)
+                _put_escaped_byte(state, (unsigned char) *p, '"');
+            l += _escaped_len((unsigned char) *p, '"');
+            p++;
+            n--;
+        }
+    }
+    return l;
+}
+
+// %q takes a string and puts it in double quotes, with '"', '\\', and
+// anything that is not printable ASCII backslash-escaped (non-printable
+// bytes as "\xNN").  The precision limits how many bytes of the
+// string are read, not how many are put.
+static void conv_quote(struct fmt_state *state) {
+    const char *p = fmt_state_arg_ptr(state);
+    const size_t n = _strnlen_s(p, (state->flags & FMT_FLAG_PRECISION) ? state->precision : (size_t) -1);
+    size_t pad = 0;
+    if (state->width) {
+        const size_t l = 2U + _out_escaped(NULL, p, n);
+        pad = l < state->width ? state->width - l : 0U;
+    }
+    if (!(state->flags & FMT_FLAG_LEFT))
+        _out_pad(state, ' ', pad);
+    fmt_state_putchar(state, '"');
+    _out_escaped(state, p, n);
+    fmt_state_putchar(state, '"');
+    if (state->flags & FMT_FLAG_LEFT)
+        _out_pad(state, ' ', pad);
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_BASE64
+static const char _base64_std[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char _base64_url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// %r takes a pointer and a size_t length, and puts the bytes
+// base64-encoded (RFC 4648), with '=' padding; the '#' flag selects the
+// URL-safe alphabet ("-_" rather than "+/").  The width and '-' pad
+// the encoding as for %s.
+static void conv_base64(struct fmt_state *state) {
+    const unsigned char *p = fmt_state_arg_ptr(state);
+    size_t len = fmt_state_arg_size(state);
+    const char *alphabet = (state->flags & FMT_FLAG_HASH) ? _base64_url : _base64_std;
+
+    const size_t l = (len / 3U + (len % 3U != 0)) * 4U;
+    const size_t pad = l < state->width ? state->width - l : 0U;
+    if (!(state->flags & FMT_FLAG_LEFT))
+        _out_pad(state, ' ', pad);
+
+    // Each 3-byte group encodes to 4 characters, and the chunk size is
+    // a multiple of 4, so a group never straddles two chunks.
+    _Static_assert(sizeof(((struct _chunkbuf *) 0)->buf) % 4 == 0);
+    struct _chunkbuf cb = {.n = 0};
+    for (; len >= 3U; p += 3, len -= 3U) { // per group
+        if (cb.n == sizeof(cb.buf))
+            _chunk_flush(state, &cb);
+        const uint32_t v = (uint32_t) p[0] << 16 | (uint32_t) p[1] << 8 | (uint32_t) p[2];
+        cb.buf[cb.n++] = alphabet[(v >> 18) & 0x3F];
+        cb.buf[cb.n++] = alphabet[(v >> 12) & 0x3F];
+        cb.buf[cb.n++] = alphabet[(v >> 6) & 0x3F];
+        cb.buf[cb.n++] = alphabet[v & 0x3F];
+    }
+    if (len) {
+        if (cb.n == sizeof(cb.buf))
+            _chunk_flush(state, &cb);
+        const uint32_t v = (uint32_t) p[0] << 16 | (len > 1U ? (uint32_t) p[1] << 8 : 0U);
+        cb.buf[cb.n++] = alphabet[(v >> 18) & 0x3F];
+        cb.buf[cb.n++] = alphabet[(v >> 12) & 0x3F];
+        cb.buf[cb.n++] = len > 1U ? alphabet[(v >> 6) & 0x3F] : '=';
+        cb.buf[cb.n++] = '=';
+    }
+    _chunk_flush(state, &cb);
+
+    if (state->flags & FMT_FLAG_LEFT)
+        _out_pad(state, ' ', pad);
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_NETADDR
+// Each address is rendered into a buffer on the stack (they are all
+// short) and then handed to _out_str() in one piece, for padding.
+
+// Render a byte in decimal, without leading zeros.  The divisions are
+// by multiplication, as the Cortex-M0+ has no divide instruction.
+static inline size_t _fmt_dec_u8(char *buf, unsigned int b) {
+    const unsigned int h = (b * 41U) >> 12; // b / 100, for b < 256
+    const unsigned int r = b - h * 100U;
+    const unsigned int t = (r * 205U) >> 11; // r / 10, for r < 100
+    size_t n = 0;
+    if (h)
+        buf[n++] = (char) ('0' + h);
+    if (h || t)
+        buf[n++] = (char) ('0' + t);
+    buf[n++] = (char) ('0' + (r - t * 10U));
+    return n;
+}
+
+static size_t _fmt_ipv4(char *buf, const unsigned char *p) {
+    size_t n = 0;
+    for (size_t i = 0; i < 4; i++) {
+        if (i)
+            buf[n++] = '.';
+        n += _fmt_dec_u8(&buf[n], p[i]);
+    }
+    return n;
+}
+
+// Render an IPv6 address per RFC 5952: lowercase hex without leading
+// zeros, the longest (first, on a tie) run of 2 or more all-zero
+// groups shortened to "::", and an IPv4-mapped address as
+// "::ffff:a.b.c.d".
+static size_t _fmt_ipv6(char *buf, const unsigned char *p) {
+    uint16_t g[8];
+    for (size_t i = 0; i < 8; i++)
+        g[i] = (uint16_t) (p[i * 2] << 8 | p[i * 2 + 1]);
+
+    // find the longest run of zero groups
+    size_t zbeg = 8, zlen = 1;
+    for (size_t i = 0, run = 0; i < 8; i++) {
+        run = g[i] ? 0 : run + 1;
+        if (run > zlen) {
+            zbeg = i + 1 - run;
+            zlen = run;
+        }
+    }
+
+    size_t n = 0;
+    if (zbeg == 0 && zlen == 5 && g[5] == 0xFFFF) {
+        for (; n < 7; n++)
+            buf[n] = "::ffff:"[n];
+        return n + _fmt_ipv4(&buf[n], &p[12]);
+    }
+    for (size_t i = 0; i < 8; i++) {
+        if (i >= zbeg && i < zbeg + zlen) {
+            if (i == zbeg)
+                buf[n++] = ':';
+            continue;
+        }
+        if (i)
+            buf[n++] = ':';
+        int shift = 12;
+        while (shift && !(g[i] >> shift))
+            shift -= 4;
+        for (; shift >= 0; shift -= 4)
+            buf[n++] = "0123456789abcdef"[(g[i] >> shift) & 0xF];
+    }
+    if (zbeg + zlen == 8)
+        buf[n++] = ':';
+    return n;
+}
+
+// %I takes a pointer to a 4-byte IPv4 address, or (%lI) to a 16-byte
+// IPv6 address, in network byte order.  The width and '-' pad the
+// address as for %s.
+static void conv_ipaddr(struct fmt_state *state) {
+    const unsigned char *p = fmt_state_arg_ptr(state);
+    char buf[sizeof("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff")];
+    _out_str(state, buf, state->size == FMT_SIZE_LONG ? _fmt_ipv6(buf, p) : _fmt_ipv4(buf, p));
+}
+
+// %M takes a pointer to a 6-byte MAC address, and puts it as
+// colon-separated lowercase hex.  The width and '-' pad the address
+// as for %s.
+static void conv_macaddr(struct fmt_state *state) {
+    const unsigned char *p = fmt_state_arg_ptr(state);
+    char buf[sizeof("ff:ff:ff:ff:ff:ff") - 1];
+    for (size_t i = 0; i < 6; i++) {
+        buf[i * 3] = "0123456789abcdef"[p[i] >> 4];
+        buf[i * 3 + 1] = "0123456789abcdef"[p[i] & 0xF];
+        if (i < 5)
+            buf[i * 3 + 2] = ':';
+    }
+    _out_str(state, buf, sizeof(buf));
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_UNITS
+// %K and %T use only integer math, so that they work (and do not pull
+// in the soft-float routines) with PICO_PRINTF_SUPPORT_FLOAT=0.  Like
+// the network addresses, they render into a buffer on the stack and
+// hand that to _out_str().
+
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+typedef unsigned long long _fmt_uunits;
+#elif defined(_PICO_PRINTF_TEST_UNITS32)
+// so that a host with a 64-bit long can test the math of a 32-bit one
+typedef uint32_t _fmt_uunits;
+#else
+typedef unsigned long _fmt_uunits;
+#endif
+
+// Read an unsigned integer argument of the size given by the size
+// modifier, as conv_uint() does.
+static _fmt_uunits _va_uunits(struct fmt_state *state) {
+    switch (state->size) {
+        case FMT_SIZE_LONG_LONG:
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+            return fmt_state_arg_ullong(state);
+#else
+            // fall through
+#endif
+        case FMT_SIZE_LONG:
+            return (_fmt_uunits) fmt_state_arg_ulong(state);
+        case FMT_SIZE_DEFAULT:
+            return fmt_state_arg_uint(state);
+        case FMT_SIZE_SHORT:
+            return (unsigned short int) fmt_state_arg_uint(state);
+        case FMT_SIZE_CHAR:
+            return (unsigned char) fmt_state_arg_uint(state);
+    }
+    __builtin_unreachable();
+}
+
+// Render `v` in decimal, zero-padded to at least `mindigits` (at most
+// 20) digits.
+static size_t _fmt_dec(char *buf, _fmt_uunits v, size_t mindigits) {
+    char rev[20];
+    size_t len = 0;
+    do { // per digit
+        rev[len++] = (char) ('0' + v % 10U);
+        v /= 10U;
+    } while (v || len < mindigits);
+    for (size_t j = 0; j < len; j++) // per digit
+        buf[j] = rev[len - 1 - j];
+    return len;
+}
+
+// %K takes an unsigned integer count of bytes, and scales it to the
+// largest IEC unit (KiB, MiB, ...) that it is at least 1 of, or with
+// the '#' flag, SI unit (kB, MB, ...).  The precision is the number of
+// decimal places (default 1, at most 9), rounded half up; counts of
+// less than 1 unit are put as a plain number of bytes ("512 B").
+static void conv_size(struct fmt_state *state) {
+    _fmt_uunits v = _va_uunits(state);
+    const bool si = state->flags & FMT_FLAG_HASH;
+    const _fmt_uunits base = si ? 1000U : 1024U;
+    size_t prec = 1;
+    if (state->flags & FMT_FLAG_PRECISION)
+        prec = state->precision < 9U ? state->precision : 9U;
+
+    char buf[sizeof("18446744073709551615.123456789 EiB")];
+    size_t n;
+    if (v < base) {
+        n = _fmt_dec(buf, v, 1);
+        buf[n++] = ' ';
+    } else {
+        // comparing v/div to base, rather than v to div*base, keeps
+        // div from overflowing
+        size_t u = 0;
+        _fmt_uunits div = base;
+        while (u < 5 && v / div >= base) {
+            div *= base;
+            u++;
+        }
+        _fmt_uunits ip = v / div;
+        _fmt_uunits rem = v % div;
+
+        // long division, a digit at a time; rem*10 would overflow a
+        // 32-bit _fmt_uunits (div is up to 10^9), so instead add rem up
+        // ten times, taking div out as we go, as acc+rem < 2*div does
+        // not overflow
+        char frac[9];
+        for (size_t i = 0; i < prec; i++) {
+            _fmt_uunits acc = 0;
+            char digit = '0';
+            for (size_t k = 0; k < 10; k++) {
+                acc += rem;
+                if (acc >= div) {
+                    acc -= div;
+                    digit++;
+                }
+            }
+            frac[i] = digit;
+            rem = acc;
+        }
+        // round half up, carrying in to the integer part, and from
+        // there in to the next unit (1023.96 KiB => "1.0 MiB")
+        if (rem >= div - rem) {
+            size_t i = prec;
+            while (i && frac[i - 1] == '9')
+                frac[--i] = '0';
+            if (i)
+                frac[i - 1]++;
+            else if (++ip == base) {
+                ip = 1;
+                u++;
+            }
+        }
+
+        n = _fmt_dec(buf, ip, 1);
+        if (prec) {
+            buf[n++] = '.';
+            for (size_t i = 0; i < prec; i++)
+                buf[n++] = frac[i];
+        }
+        buf[n++] = ' ';
+        buf[n++] = (si ? "kMGTPE" : "KMGTPE")[u];
+        if (!si)
+            buf[n++] = 'i';
+    }
+    buf[n++] = 'B';
+    _out_str(state, buf, n);
+}
+
+// %T takes an unsigned integer count of milliseconds, and puts it as
+// "h:mm:ss.fff" (the hours are not wrapped in to days).  The precision
+// is the number of decimal places of the seconds (default 3, at most
+// 3), rounded half up.  The '#' flag leaves off leading fields that
+// are 0 ("2:03.456" or "3.456" rather than "0:02:03.456").
+static void conv_duration(struct fmt_state *state) {
+    _fmt_uunits v = _va_uunits(state);
+    size_t prec = 3;
+    if (state->flags & FMT_FLAG_PRECISION)
+        prec = state->precision < 3U ? state->precision : 3U;
+
+    // Round to a whole number of the last place, then split that; this
+    // never goes back to milliseconds, which could overflow.
+    static const unsigned int pow10[] = {1U, 10U, 100U, 1000U};
+    const unsigned int unit = pow10[3 - prec];
+    _fmt_uunits q = v / unit;
+    if (v % unit >= unit - v % unit)
+        q++;
+    const _fmt_uunits secs = q / pow10[prec];
+    const unsigned int frac = (unsigned int) (q % pow10[prec]);
+    const _fmt_uunits h = secs / 3600U;
+    const unsigned int m = (unsigned int) (secs / 60U % 60U);
+    const unsigned int sec = (unsigned int) (secs % 60U);
+
+    char buf[sizeof("5124095576030:25:51.616")];
+    size_t n = 0;
+    const bool compact = state->flags & FMT_FLAG_HASH;
+    if (h || !compact) {
+        n += _fmt_dec(&buf[n], h, 1);
+        buf[n++] = ':';
+    }
+    if (h || m || !compact) {
+        n += _fmt_dec(&buf[n], m, n ? 2 : 1);
+        buf[n++] = ':';
+    }
+    n += _fmt_dec(&buf[n], sec, n ? 2 : 1);
+    if (prec) {
+        buf[n++] = '.';
+        n += _fmt_dec(&buf[n], frac, prec);
+    }
+    _out_str(state, buf, n);
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_STRUCT
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+#define _ntoa_field _ntoall
+#else
+// without long long support, 8-byte fields are truncated, as %p is
+#define _ntoa_field _ntoal
+#endif
+
+// Put an integer field, in decimal or (zero-padded to `size` bytes) hex.
+static void _out_field_int(struct fmt_state *state, uint64_t absval, bool negative, bool hex, size_t size) {
+    struct fmt_state substate = {
+        .flags = hex ? FMT_FLAG_ZEROPAD : 0,
+        .width = hex ? (unsigned) size * 2U : 0U,
+        .specifier = hex ? 'x' : 'd',
+        .ctx = state->ctx,
+    };
+    if (hex)
+        fmt_state_write(state, "0x", 2);
+    _ntoa_field(&substate, absval, negative, hex ? 16U : 10U);
+}
+
+static inline void _out_name(struct fmt_state *state, const char *name) {
+    fmt_state_write(state, name, _strnlen_s(name, (size_t) -1));
+}
+
+static void _out_field_flags(struct fmt_state *state, const struct fmt_field *f, uint64_t v) {
+    if (!v) {
+        fmt_state_putchar(state, '0');
+        return;
+    }
+    bool first = true;
+    for (size_t bit = 0; bit < f->nnames && bit < 64 && v >> bit; bit++) {
+        if (!((v >> bit) & 1U) || !f->names[bit])
+            continue;
+        if (!first)
+            fmt_state_putchar(state, '|');
+        _out_name(state, f->names[bit]);
+        v &= ~((uint64_t) 1 << bit);
+        first = false;
+    }
+    if (v) {
+        if (!first)
+            fmt_state_putchar(state, '|');
+        _out_field_int(state, v, false, true, 0);
+    }
+}
+
+static void _out_field(struct fmt_state *state, const struct fmt_field *f, const void *p) {
+    switch ((enum fmt_field_type) f->type) {
+        case FMT_FIELD_BOOL:
+            if (*(const bool *) p)
+                fmt_state_write(state, "true", 4);
+            else
+                fmt_state_write(state, "false", 5);
+            return;
+        case FMT_FIELD_STR: {
+            const char *str;
+            memcpy(&str, p, sizeof(str));
+            if (!str) {
+                fmt_state_write(state, "NULL", 4);
+                return;
+            }
+            fmt_state_putchar(state, '"');
+            _out_name(state, str);
+            fmt_state_putchar(state, '"');
+            return;
+        }
+        case FMT_FIELD_CHARS:
+            fmt_state_putchar(state, '"');
+            fmt_state_write(state, p, _strnlen_s(p, f->size));
+            fmt_state_putchar(state, '"');
+            return;
+        case FMT_FIELD_UINT:
+        case FMT_FIELD_SINT:
+            break;
+    }
+
+    // load the integer, zero- or sign-extended; with memcpy(), as the
+    // struct may be packed and the field unaligned
+    uint64_t v;
+    int64_t sv;
+    switch (f->size) {
+        case 1: {
+            uint8_t x;
+            memcpy(&x, p, sizeof(x));
+            v = x;
+            sv = (int8_t) x;
+            break;
+        }
+        case 2: {
+            uint16_t x;
+            memcpy(&x, p, sizeof(x));
+            v = x;
+            sv = (int16_t) x;
+            break;
+        }
+        case 4: {
+            uint32_t x;
+            memcpy(&x, p, sizeof(x));
+            v = x;
+            sv = (int32_t) x;
+            break;
+        }
+        default: { // 8; _FMT_FIELD() rejects any other size
+            uint64_t x;
+            memcpy(&x, p, sizeof(x));
+            v = x;
+            sv = (int64_t) x;
+            break;
+        }
+    }
+    const bool negative = f->type == FMT_FIELD_SINT && sv < 0;
+
+    switch ((enum fmt_field_display) f->display) {
+        case FMT_DISPLAY_ENUM:
+            if (!negative && v < f->nnames && f->names[v]) {
+                _out_name(state, f->names[v]);
+                return;
+            }
+            break;
+        case FMT_DISPLAY_FLAGS:
+            _out_field_flags(state, f, v);
+            return;
+        case FMT_DISPLAY_HEX:
+            _out_field_int(state, v, false, true, f->size);
+            return;
+        case FMT_DISPLAY_DEC:
+            break;
+    }
+    _out_field_int(state, negative ? 0U - (uint64_t) sv : v, negative, false, 0);
+}
+
+// %R takes a pointer to a struct and a pointer to the `struct
+// fmt_struct` that describes it, and puts each field as "name=value";
+// separated by ", " inside of "{}", or with the '#' flag, each on its
+// own line.
+static void conv_struct(struct fmt_state *state) {
+    const unsigned char *obj = fmt_state_arg_ptr(state);
+    const struct fmt_struct *desc = fmt_state_arg_ptr(state);
+    const bool lines = state->flags & FMT_FLAG_HASH;
+
+    if (!lines)
+        fmt_state_putchar(state, '{');
+    for (size_t i = 0; i < desc->nfields; i++) { // per field
+        const struct fmt_field *f = &desc->fields[i];
+        if (i && !lines)
+            fmt_state_write(state, ", ", 2);
+        fmt_state_write(state, f->name, f->name_len);
+        fmt_state_putchar(state, '=');
+        _out_field(state, f, &obj[f->offset]);
+        if (lines)
+            fmt_state_putchar(state, '\n');
+    }
+    if (!lines)
+        fmt_state_putchar(state, '}');
+}
+#endif
+
+#if PICO_PRINTF_SUPPORT_VALUE
+// %v takes a fmt_value_fn_t and a pointer, and has the one format the
+// other; the function gets the flags, width, and precision in `state`.
+static void conv_value(struct fmt_state *state) {
+    const fmt_value_fn_t fn = fmt_state_arg_fn(state);
+    const void *obj = fmt_state_arg_ptr(state);
+    fn(state, obj);
+}
+#endif
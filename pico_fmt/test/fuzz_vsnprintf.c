@@ -0,0 +1,588 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// \brief Coverage-guided fuzz harness for fmt_vsnprintf(), and a
+//        replay driver that uses the checked-in corpus as a benchmark
+//        workload.
+//
+// An input is a format string, a NUL byte, and then a pool of bytes
+// that arguments are drawn from.  The harness splits the format in to
+// segments that each contain at most one conversion, works out what
+// argument types that conversion consumes (mirroring the parser in
+// printf.c), draws those arguments from the pool, and renders the
+// segment with fmt_snprintf().  For the conversions that pico-fmt
+// implements identically to glibc, the segment is also rendered with
+// snprintf() and the two are diffed.
+//
+// Build it one of three ways:
+//
+//  - As a libFuzzer target:
+//
+//        clang -fsanitize=fuzzer,address,undefined -DFUZZ_LIBFUZZER ...
+//
+//    (see `make fuzz` and `make fuzz-merge` in the GNUmakefile).
+//
+//  - As a plain executable (the default, and what CMake builds), which
+//    takes a list of files and/or directories, runs each input once
+//    to check it, and then times it.  This is suitable for use with
+//    AFL (`afl-fuzz -i pico_fmt/test/fuzz_corpus -o out --
+//    ./fuzz_vsnprintf @@`), and is how the corpus is used as a
+//    benchmark workload and a latency regression test: an input that
+//    takes longer than
+//
+//        FUZZ_CEILING_BASE_NS + FUZZ_CEILING_BYTE_NS*output_bytes
+//
+//    (or the `-b`/`-B` command-line overrides) counts as a failure.
+//    With `-n 0`, the inputs are only checked, not timed; that is how
+//    ctest runs it, as wall-clock ceilings are flaky on a loaded or
+//    instrumented machine (the timed run is the `fuzz_latency` CMake
+//    target).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/fmt_install.h"
+#include "pico/fmt_printf.h"
+
+// The largest width/precision that the harness will pass through.
+// Larger inputs are discarded rather than clamped, so that the
+// fuzzer does not learn to waste time on them.
+#ifndef FUZZ_MAX_WIDTH
+#define FUZZ_MAX_WIDTH 100000
+#endif
+
+// The deepest `%N` nesting that the harness will pass through.
+#ifndef FUZZ_MAX_DEPTH
+#define FUZZ_MAX_DEPTH 256
+#endif
+
+#ifndef FUZZ_CEILING_BASE_NS
+#define FUZZ_CEILING_BASE_NS 200000
+#endif
+
+#ifndef FUZZ_CEILING_BYTE_NS
+#define FUZZ_CEILING_BYTE_NS 50
+#endif
+
+#define FUZZ_BUF_SIZE 256
+
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+// argument pool //////////////////////////////////////////////////////////////
+
+struct pool {
+    const uint8_t *dat;
+    size_t len;
+    char strbuf[4][64];
+    unsigned strcnt;
+};
+
+static uint64_t pool_bytes(struct pool *p, size_t n) {
+    uint64_t ret = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t b = 0;
+        if (p->len) {
+            b = *(p->dat++);
+            p->len--;
+        }
+        ret |= b << (8 * i);
+    }
+    return ret;
+}
+
+// A `*` width or precision is only 16 bits, which keeps it within
+// the default FUZZ_MAX_WIDTH without any clamping.
+static int pool_star(struct pool *p) {
+    return (int) (int16_t) pool_bytes(p, 2);
+}
+
+static const char *pool_str(struct pool *p) {
+    char *buf = p->strbuf[p->strcnt++ % 4];
+    size_t n = (size_t) pool_bytes(p, 1) % sizeof(p->strbuf[0]);
+    size_t i;
+    for (i = 0; i < n && p->len; i++)
+        buf[i] = (char) pool_bytes(p, 1);
+    buf[i] = '\0';
+    return buf;
+}
+
+// the `%N` nesting specifier /////////////////////////////////////////////////
+
+static void conv_nest(struct fmt_state *state) {
+    int depth = va_arg(*state->args, int);
+    if (depth > 0)
+        fmt_state_printf(state, "(%N)", depth - 1);
+    else
+        fmt_state_putchar(state, '.');
+}
+
+// segments ///////////////////////////////////////////////////////////////////
+
+enum arg_type {
+    ARG_NONE,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONG_LONG,
+    ARG_PTRDIFF,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_STR,
+    ARG_PTR,
+    ARG_NEST,
+};
+
+struct segment {
+    char fmt[96];
+    int nstars;
+    int stars[2];
+    enum arg_type type;
+    bool diffable;
+};
+
+// Parse one segment off of `*format`, mirroring the parser in
+// `_vfctprintf()`.  Returns false if the segment should be discarded.
+static bool parse_segment(const char **format, struct segment *seg) {
+    const char *beg = *format;
+    const char *p = beg;
+    seg->nstars = 0;
+    seg->type = ARG_NONE;
+    seg->diffable = true;
+
+    while (*p && *p != '%')
+        p++;
+    if (*p == '%') {
+        const char *pct = p++;
+        while (*p && strchr("0-+ #", *p))
+            p++;
+        if (*p == '*') {
+            seg->nstars++;
+            p++;
+        } else {
+            unsigned long w = 0;
+            while ('0' <= *p && *p <= '9') {
+                w = w * 10 + (unsigned long) (*p - '0');
+                if (w > FUZZ_MAX_WIDTH)
+                    return false;
+                p++;
+            }
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                seg->nstars++;
+                p++;
+            } else {
+                unsigned long w = 0;
+                while ('0' <= *p && *p <= '9') {
+                    w = w * 10 + (unsigned long) (*p - '0');
+                    if (w > FUZZ_MAX_WIDTH)
+                        return false;
+                    p++;
+                }
+            }
+        }
+        enum arg_type size = ARG_INT;
+        const char *size_beg = p;
+        switch (*p) {
+            case 'l':
+                p++;
+                size = ARG_LONG;
+                if (*p == 'l') {
+                    p++;
+                    size = ARG_LONG_LONG;
+                }
+                break;
+            case 'h':
+                p++;
+                if (*p == 'h')
+                    p++;
+                break;
+            case 't':
+                p++;
+                size = ARG_PTRDIFF;
+                break;
+            case 'j':
+                p++;
+                size = ARG_INTMAX;
+                break;
+            case 'z':
+                p++;
+                size = ARG_SIZE;
+                break;
+        }
+        // glibc rejects size modifiers on non-integer conversions.
+        const bool sized = p != size_beg;
+        switch (*p) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                seg->type = size;
+                break;
+            case 'b':
+                // glibc only grew %b in 2.35.
+                seg->type = size;
+                seg->diffable = false;
+                break;
+            case 'c':
+                seg->type = ARG_INT;
+                seg->diffable = !sized;
+                break;
+            case 's':
+                seg->type = ARG_STR;
+                seg->diffable = !sized;
+                break;
+            case '%':
+                // glibc does not accept flags/width/size on "%%".
+                seg->diffable = p == pct + 1;
+                break;
+            case 'p':
+                seg->type = ARG_PTR;
+                seg->diffable = false;
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                seg->type = ARG_DOUBLE;
+                seg->diffable = false;
+                break;
+            case 'N':
+                seg->type = ARG_NEST;
+                seg->diffable = false;
+                break;
+            default:
+                seg->diffable = false;
+                break;
+        }
+        if (*p)
+            p++;
+    }
+
+    if ((size_t) (p - beg) >= sizeof(seg->fmt))
+        return false;
+    memcpy(seg->fmt, beg, (size_t) (p - beg));
+    seg->fmt[p - beg] = '\0';
+    *format = p;
+    return true;
+}
+
+// Known places where pico-fmt intentionally (or at least knowingly)
+// differs from glibc for the otherwise-diffable conversions.
+static bool known_deviation(const struct segment *seg) {
+    const char *spec = strchr(seg->fmt, '%');
+    if (!spec)
+        return false;
+    // "%#o": C says that '#' increases the precision so that the
+    // first digit is a '0'; pico-fmt instead always emits a "0"
+    // prefix (for non-zero values), even if there are already leading
+    // zeros from the precision or the '0' flag.
+    if (strchr(spec, '#') && strchr(spec, 'o'))
+        return true;
+    return false;
+}
+
+#define CALL(fn, ...)                                                                     \
+    do {                                                                                  \
+        switch (seg->nstars) {                                                            \
+            case 0:                                                                       \
+                ret = fn(buf, size, seg->fmt, __VA_ARGS__);                               \
+                break;                                                                    \
+            case 1:                                                                       \
+                ret = fn(buf, size, seg->fmt, seg->stars[0], __VA_ARGS__);                \
+                break;                                                                    \
+            default:                                                                      \
+                ret = fn(buf, size, seg->fmt, seg->stars[0], seg->stars[1], __VA_ARGS__); \
+                break;                                                                    \
+        }                                                                                 \
+    } while (0)
+
+struct value {
+    long long i;
+    double d;
+    const char *s;
+};
+
+#define RENDER(fn)                                                    \
+    static int render_##fn(const struct segment *seg, struct value v, \
+                           char *buf, size_t size) {                  \
+        int ret = 0;                                                  \
+        switch (seg->type) {                                          \
+            case ARG_NONE:                                            \
+                CALL(fn, 0);                                          \
+                break;                                                \
+            case ARG_INT:                                             \
+            case ARG_NEST:                                            \
+                CALL(fn, (int) v.i);                                  \
+                break;                                                \
+            case ARG_LONG:                                            \
+                CALL(fn, (long) v.i);                                 \
+                break;                                                \
+            case ARG_LONG_LONG:                                       \
+                CALL(fn, (long long) v.i);                            \
+                break;                                                \
+            case ARG_PTRDIFF:                                         \
+                CALL(fn, (ptrdiff_t) v.i);                            \
+                break;                                                \
+            case ARG_INTMAX:                                          \
+                CALL(fn, (intmax_t) v.i);                             \
+                break;                                                \
+            case ARG_SIZE:                                            \
+                CALL(fn, (size_t) v.i);                               \
+                break;                                                \
+            case ARG_DOUBLE:                                          \
+                CALL(fn, v.d);                                        \
+                break;                                                \
+            case ARG_STR:                                             \
+                CALL(fn, v.s);                                        \
+                break;                                                \
+            case ARG_PTR:                                             \
+                CALL(fn, (void *) (uintptr_t) v.i);                   \
+                break;                                                \
+        }                                                             \
+        return ret;                                                   \
+    }
+RENDER(fmt_snprintf)
+RENDER(snprintf)
+
+// entry point ////////////////////////////////////////////////////////////////
+
+static size_t fuzz_output_bytes;
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static bool installed = false;
+    if (!installed) {
+        fmt_install('N', conv_nest);
+        installed = true;
+    }
+
+    const uint8_t *nul = memchr(data, '\0', size);
+    if (!nul)
+        return -1;
+    const char *format = (const char *) data;
+    struct pool pool = {
+        .dat = nul + 1,
+        .len = size - (size_t) (nul + 1 - data),
+    };
+
+    // The first pool byte picks the buffer size, to exercise truncation.
+    size_t bufsize = (size_t) pool_bytes(&pool, 1) % FUZZ_BUF_SIZE;
+
+    fuzz_output_bytes = 0;
+    while (*format) {
+        struct segment seg;
+        if (!parse_segment(&format, &seg))
+            return -1;
+        for (int i = 0; i < seg.nstars; i++)
+            seg.stars[i] = pool_star(&pool);
+
+        struct value v = {0};
+        switch (seg.type) {
+            case ARG_NONE:
+                break;
+            case ARG_NEST:
+                v.i = (long long) (pool_bytes(&pool, 2) % (FUZZ_MAX_DEPTH + 1));
+                break;
+            case ARG_INT:
+            case ARG_LONG:
+            case ARG_LONG_LONG:
+            case ARG_PTRDIFF:
+            case ARG_INTMAX:
+            case ARG_SIZE:
+            case ARG_PTR:
+                v.i = (long long) pool_bytes(&pool, 8);
+                break;
+            case ARG_DOUBLE: {
+                uint64_t bits = pool_bytes(&pool, 8);
+                memcpy(&v.d, &bits, sizeof(v.d));
+                break;
+            }
+            case ARG_STR:
+                v.s = pool_str(&pool);
+                break;
+        }
+
+        char act[FUZZ_BUF_SIZE + 1];
+        memset(act, 0x7F, sizeof(act));
+        int act_ret = render_fmt_snprintf(&seg, v, act, bufsize);
+        if (act_ret < 0)
+            abort();
+        if (bufsize && memchr(act, '\0', bufsize) == NULL)
+            abort(); // not NUL-terminated
+        if (act[bufsize] != 0x7F)
+            abort(); // overflowed
+        fuzz_output_bytes += (size_t) act_ret;
+
+        if (seg.diffable && !known_deviation(&seg)) {
+            char exp[FUZZ_BUF_SIZE + 1];
+            int exp_ret = render_snprintf(&seg, v, exp, bufsize);
+            if (act_ret != exp_ret ||
+                (bufsize && memcmp(act, exp, (size_t) act_ret < bufsize ? (size_t) act_ret + 1 : bufsize))) {
+                fprintf(stderr, "mismatch: fmt=\"%s\" stars=[%d,%d] i=%lld s=\"%s\" size=%zu\n"
+                                "\tactual  : %d \"%.*s\"\n"
+                                "\texpected: %d \"%.*s\"\n",
+                        seg.fmt, seg.stars[0], seg.stars[1], v.i, v.s ? v.s : "", bufsize,
+                        act_ret, (int) bufsize, act,
+                        exp_ret, (int) bufsize, exp);
+                abort();
+            }
+        }
+    }
+    return 0;
+}
+
+// replay driver //////////////////////////////////////////////////////////////
+
+#ifndef FUZZ_LIBFUZZER
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+static struct {
+    unsigned iterations;
+    uint64_t ceiling_base_ns;
+    uint64_t ceiling_byte_ns;
+
+    unsigned ninputs;
+    unsigned nfailures;
+    uint64_t total_ns;
+    uint64_t total_bytes;
+} replay = {
+    .iterations = 20,
+    .ceiling_base_ns = FUZZ_CEILING_BASE_NS,
+    .ceiling_byte_ns = FUZZ_CEILING_BYTE_NS,
+};
+
+static void replay_file(const char *filename) {
+    FILE *fh = fopen(filename, "rb");
+    if (!fh) {
+        perror(filename);
+        replay.nfailures++;
+        return;
+    }
+    static uint8_t data[1 << 16];
+    size_t size = fread(data, 1, sizeof(data), fh);
+    fclose(fh);
+
+    // check
+    if (LLVMFuzzerTestOneInput(data, size) < 0)
+        return; // discarded
+    size_t bytes = fuzz_output_bytes;
+    replay.ninputs++;
+    replay.total_bytes += bytes;
+    if (!replay.iterations)
+        return;
+
+    // time; take the minimum to filter out scheduling noise
+    uint64_t best = UINT64_MAX;
+    for (unsigned i = 0; i < replay.iterations; i++) {
+        uint64_t beg = now_ns();
+        LLVMFuzzerTestOneInput(data, size);
+        uint64_t dur = now_ns() - beg;
+        if (dur < best)
+            best = dur;
+    }
+
+    replay.total_ns += best;
+
+    uint64_t ceiling = replay.ceiling_base_ns + replay.ceiling_byte_ns * bytes;
+    if (best > ceiling) {
+        printf("failure: %s: took %luns to emit %zu bytes (ceiling: %luns)\n",
+               filename, (unsigned long) best, bytes, (unsigned long) ceiling);
+        replay.nfailures++;
+    }
+}
+
+static void replay_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        perror(path);
+        replay.nfailures++;
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        replay_file(path);
+        return;
+    }
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        replay.nfailures++;
+        return;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        if (ent->d_name[0] == '.')
+            continue;
+        char child[4096];
+        snprintf(child, sizeof(child), "%s/%s", path, ent->d_name);
+        replay_path(child);
+    }
+    closedir(dir);
+}
+
+int main(int argc, char *argv[]) {
+    int i;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (i + 1 >= argc)
+            goto usage;
+        switch (argv[i][1]) {
+            case 'n':
+                replay.iterations = (unsigned) strtoul(argv[++i], NULL, 0);
+                break;
+            case 'b':
+                replay.ceiling_base_ns = strtoull(argv[++i], NULL, 0);
+                break;
+            case 'B':
+                replay.ceiling_byte_ns = strtoull(argv[++i], NULL, 0);
+                break;
+            default:
+                goto usage;
+        }
+    }
+    if (i == argc)
+        goto usage;
+    for (; i < argc; i++)
+        replay_path(argv[i]);
+
+    printf("%u inputs, %lu bytes in %luns (%.1f MB/s)\n",
+           replay.ninputs,
+           (unsigned long) replay.total_bytes,
+           (unsigned long) replay.total_ns,
+           replay.total_ns ? (double) replay.total_bytes * 1e3 / (double) replay.total_ns : 0.0);
+    if (replay.nfailures) {
+        printf("%u failures\n", replay.nfailures);
+        return 1;
+    }
+    printf("success!\n");
+    return 0;
+
+usage:
+    fprintf(stderr, "Usage: %s [-n ITERATIONS] [-b CEILING_BASE_NS] [-B CEILING_BYTE_NS] FILE_OR_DIR...\n", argv[0]);
+    return 2;
+}
+
+#endif // FUZZ_LIBFUZZER
@@ -0,0 +1,291 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// \brief Unit tests for the C++ front end (pico/fmt.hpp)
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "pico/fmt.hpp"
+#include "pico/fmt_sinks.hpp"
+#include "pico/fmt_static.hpp"
+#include "pico/fmt_install.h"
+
+static const char *grp_name;
+static unsigned int failures = 0;
+
+#define TEST_CASE(GRP_NAME, ...)                                                                                     \
+    do {                                                                                                             \
+        grp_name = GRP_NAME;                                                                                         \
+        printf("%.70s\n", "== " GRP_NAME " ======================================================================"); \
+    } while (0)
+#define REQUIRE(expr) _REQUIRE(expr, #expr)
+#define _REQUIRE(expr, expr_str)                                                                       \
+    do {                                                                                               \
+        if (!(expr)) {                                                                                 \
+            printf("failure: %s:%u:%s: REQUIRE failed: %s\n", __FILE__, __LINE__, grp_name, expr_str); \
+            failures++;                                                                                \
+        }                                                                                              \
+    } while (0)
+#define REQUIRE_STREQ(act, exp)                                 \
+    do {                                                        \
+        if (strcmp(act, exp)) {                                 \
+            printf("failure: %s:%u:%s: REQUIRE_STREQ failed:\n" \
+                   "\tactual  : \"%s\"\n"                       \
+                   "\texpected: \"%s\"\n",                      \
+                   __FILE__, __LINE__, grp_name,                \
+                   act, exp);                                   \
+            failures++;                                         \
+        }                                                       \
+    } while (0)
+
+// Check that FMT_STATIC_SPRINT() gives the same output as the engine.
+#define REQUIRE_STATIC(...)                                             \
+    do {                                                                \
+        static constexpr auto _static = FMT_STATIC_SPRINT(__VA_ARGS__); \
+        const std::string _runtime = fmt::sprint(__VA_ARGS__);          \
+        REQUIRE_STREQ(_static.c_str(), _runtime.c_str());               \
+        REQUIRE(_static.size() == _runtime.size());                     \
+    } while (0)
+
+static constexpr const char *version_name = "pico-fmt";
+static constexpr int version_major = 1;
+
+// A sink that appends to a fixed buffer, recording each chunk as "|chunk".
+struct chunk_sink {
+    char buf[100];
+    size_t len;
+
+    void operator()(const char *p, size_t n) {
+        buf[len++] = '|';
+        memcpy(&buf[len], p, n);
+        len += n;
+        buf[len] = '\0';
+    }
+};
+
+static char fn_buffer[100];
+
+static void fn_sink(const char *p, size_t n) {
+    strncat(fn_buffer, p, n);
+}
+
+enum color { RED, GREEN, BLUE };
+
+struct millivolts {
+    int32_t mv;
+};
+
+template <>
+struct fmt::formatter<millivolts> {
+    // "1.234V"; the width and flags apply to the whole volts.
+    static void format(fmt_state *state, const millivolts &v) {
+        fmt::convert<'d'>(state, v.mv / 1000);
+        fmt_state sub = *state;
+        sub.flags = FMT_FLAG_ZEROPAD;
+        sub.width = 3;
+        fmt_state_putchar(state, '.');
+        fmt::convert<'u'>(&sub, (uint16_t) (v.mv % 1000));
+        fmt_state_putchar(state, 'V');
+    }
+};
+
+enum class led { off, on };
+
+template <>
+struct fmt::formatter<led> {
+    static void format(fmt_state *state, led v) {
+        fmt::convert<'s'>(state, v == led::on ? "on" : "off");
+    }
+};
+
+static void conv_angle(struct fmt_state *state) {
+    fmt_state_putchar(state, '<');
+    fmt_state_printf(state, "%d", fmt_state_arg_int(state));
+    fmt_state_putchar(state, '>');
+}
+
+int main() {
+    TEST_CASE("print_to", "[]");
+    {
+        char buffer[100] = "";
+        auto sink = [&](const char *p, size_t n) { strncat(buffer, p, n); };
+
+        REQUIRE(fmt::print_to(sink, "%d|%i|%u|%x|%o|%b", -42, 42, 42U, 0xbeefU, 8, 5) == 21);
+        REQUIRE_STREQ(buffer, "-42|42|42|beef|10|101");
+
+        buffer[0] = '\0';
+        fmt::print_to(sink, "%ld|%lld|%hhd|%hu|%zu|%td|%jd", -1L, 1LL << 40, 300, 70000, sizeof(int), (ptrdiff_t) -3, (intmax_t) 4);
+        REQUIRE_STREQ(buffer, "-1|1099511627776|44|4464|4|-3|4");
+
+        buffer[0] = '\0';
+        fmt::print_to(sink, "%c%c|%s|%-6s|%.2s", 'o', 'k', "str", "left", "truncated");
+        REQUIRE_STREQ(buffer, "ok|str|left  |tr");
+
+        buffer[0] = '\0';
+        fmt::print_to(sink, "%*d|%-*d|%.*f|%%", 5, 1, 3, 2, 2, 3.14159);
+        REQUIRE_STREQ(buffer, "    1|2  |3.14|%");
+
+        // Integers are matched by size, so fixed-width types work
+        // whichever of int/long they happen to be.
+        buffer[0] = '\0';
+        fmt::print_to(sink, "%u|%d|%lld|%d|%u", (uint32_t) 7, (int16_t) -7, (int64_t) 7, GREEN, true);
+        REQUIRE_STREQ(buffer, "7|-7|7|1|1");
+
+        buffer[0] = '\0';
+        const char *str = "pointer";
+        char arr[] = "array";
+        fmt::print_to(sink, "%s|%s|%p", str, arr, (void *) 0x1234);
+        REQUIRE(!strncmp(buffer, "pointer|array|", 14));
+        REQUIRE(strstr(buffer, "1234"));
+    }
+
+    TEST_CASE("print_to sinks", "[]");
+    {
+        chunk_sink cs{};
+        fmt::print_to(cs, "%s!", "hello");
+        REQUIRE_STREQ(cs.buf, "|hello|!");
+
+        const char *strs[] = {"a", "b"};
+        for (const char *s : strs)
+            fmt::print_to(fn_sink, "%s", s);
+        fmt::print_to(&fn_sink, "%d", 3);
+        REQUIRE_STREQ(fn_buffer, "ab3");
+    }
+
+    TEST_CASE("container sinks", "[]");
+    {
+        std::string str = "log:";
+        fmt::print_to(fmt::string_sink{str}, " %s=%d", "a", 1);
+        fmt::print_to(fmt::string_sink{str}, " %s=%d", "b", 2);
+        REQUIRE(str == "log: a=1 b=2");
+
+        char buf[8];
+        fmt::span_sink ss{buf};
+        REQUIRE(fmt::print_to(ss, "%s|%d", "truncated", 12345) == 15);
+        REQUIRE(ss.len == 8);
+        REQUIRE(ss.view() == "truncate");
+
+        fmt::span_sink empty{std::span<char>()};
+        REQUIRE(fmt::print_to(empty, "%d", 1) == 1);
+        REQUIRE(empty.len == 0);
+
+        std::vector<char> vec;
+        fmt::print_to(fmt::iterator_sink{std::back_inserter(vec)}, "%s-%03d", "it", 7);
+        REQUIRE(std::string(vec.begin(), vec.end()) == "it-007");
+
+        REQUIRE(fmt::print_to(nullptr, "%s-%03d", "it", 7) == 6);
+        REQUIRE(fmt::sprint("%5s|%x", "ab", 255U) == "   ab|ff");
+        REQUIRE(fmt::sprint("") == "");
+#if PICO_PRINTF_SUPPORT_BRACES
+        REQUIRE(fmt::format("{:<4}|{}", "ab", -3) == "ab  |-3");
+#endif
+    }
+
+#if PICO_PRINTF_SUPPORT_VALUE
+    TEST_CASE("formatter", "[]");
+    {
+        char buffer[100] = "";
+        auto sink = [&](const char *p, size_t n) { strncat(buffer, p, n); };
+
+        REQUIRE(fmt::print_to(sink, "%v|%v|%-5v|%5v|%d", millivolts{1234}, led::on, led::off, led::on, 3) == 23);
+        REQUIRE_STREQ(buffer, "1.234V|on|off  |   on|3");
+
+        buffer[0] = '\0';
+        const millivolts rails[] = {{3300}, {12005}};
+        fmt::print_to(sink, "%+3v %+3v", rails[0], rails[1]);
+        REQUIRE_STREQ(buffer, " +3.300V +12.005V");
+
+        REQUIRE(fmt::sprint("%s=%v", "led", led::off) == "led=off");
+#if PICO_PRINTF_SUPPORT_BRACES
+        REQUIRE(fmt::format("{}|{:>4}|{}", millivolts{5}, led::off, 6) == "0.005V| off|6");
+#endif
+    }
+#endif
+
+    TEST_CASE("FMT_STATIC_SPRINT", "[]");
+    {
+        static constexpr auto banner = FMT_STATIC_SPRINT("%s v%d.%02d", version_name, version_major, 7);
+        static_assert(sizeof(banner) == sizeof("pico-fmt v1.07"));
+        REQUIRE_STREQ(banner.c_str(), "pico-fmt v1.07");
+
+        REQUIRE_STATIC("");
+        REQUIRE_STATIC("plain %% text");
+        REQUIRE_STATIC("%d|%i|%d|%d|%u", 0, -42, 2147483647, -2147483647 - 1, 4294967295U);
+        REQUIRE_STATIC("%ld|%lld|%llu|%hhd|%hd|%hhu|%hu", -1L, -(1LL << 40), ~0ULL, 300, 70000, 300, 70000);
+        REQUIRE_STATIC("%zu|%td|%jd", sizeof(int), (ptrdiff_t) -3, (intmax_t) 4);
+        REQUIRE_STATIC("%x|%X|%#x|%#X|%o|%#o|%b|%#b|%#x|%#o", 0xbeefU, 0xbeefU, 255U, 255U, 8U, 8U, 5U, 5U, 0U, 0U);
+        REQUIRE_STATIC("%+d|% d|%+d|% d|%+u|% u|%+d", 5, 5, -5, -5, 5U, 5U, 0);
+        REQUIRE_STATIC("%5d|%-5d|%05d|%-05d|%+05d|% 05d|%05d", 42, 42, 42, 42, 42, 42, -42);
+        REQUIRE_STATIC("%.3d|%.0d|%.0d|%5.3d|%-5.3d|%05.3d|%.d", 7, 0, 1, -7, 7, 7, 0);
+        REQUIRE_STATIC("%#8x|%#08x|%-#8x|%#.4x|%#10.4o|%#b", 0x1fU, 0x1fU, 0x1fU, 0x1fU, 8U, 0U);
+        REQUIRE_STATIC("%*d|%-*d|%*d|%.*d|%.*d", 5, 1, 3, 2, -4, 3, 3, 4, -1, 5);
+        REQUIRE_STATIC("%c|%3c|%-3c|%s|%6s|%-6s|%.2s|%.0s|%*.*s|", 'a', 'b', 'c', "str", "right", "left", "truncated", "gone", 6, 3, "abcdef");
+        REQUIRE_STATIC("%d|%u|%d|%c", RED, (uint16_t) 65535, true, 65);
+    }
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+    TEST_CASE("print_to float", "[]");
+    {
+        char buffer[100] = "";
+        auto sink = [&](const char *p, size_t n) { strncat(buffer, p, n); };
+
+        fmt::print_to(sink, "%.3f|%8.2f|%G", 1.5f, -2.25, 12345.678);
+        REQUIRE_STREQ(buffer, "1.500|   -2.25|12345.7");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_SLICE && PICO_PRINTF_SUPPORT_HEXDUMP
+    TEST_CASE("print_to extensions", "[]");
+    {
+        char buffer[100] = "";
+        auto sink = [&](const char *p, size_t n) { strncat(buffer, p, n); };
+
+        const unsigned char bytes[] = {0xde, 0xad};
+        fmt::print_to(sink, "%S|%H", "slice", (size_t) 3, bytes, sizeof(bytes));
+        REQUIRE_STREQ(buffer, "sli|dead");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_BRACES
+    TEST_CASE("format_to", "[]");
+    {
+        char buffer[100] = "";
+        auto sink = [&](const char *p, size_t n) { strncat(buffer, p, n); };
+
+        REQUIRE(fmt::format_to(sink, "{}|{}|{}|{}|{}", -1, 2U, 'c', "str", GREEN) == 12);
+        REQUIRE_STREQ(buffer, "-1|2|c|str|1");
+
+        // The size comes from the argument, even with a type.
+        buffer[0] = '\0';
+        fmt::format_to(sink, "{}|{:x}|{:X}|{:#o}|{}", -1L, 1LL << 40, (uint16_t) 0xabc, 8U, (size_t) 5);
+        REQUIRE_STREQ(buffer, "-1|10000000000|ABC|010|5");
+
+        buffer[0] = '\0';
+        fmt::format_to(sink, "{:6}|{:>6}|{:6}|{:<6}|{:+06}|{{}}", "ab", "cd", 12, 34, 5);
+        REQUIRE_STREQ(buffer, "ab    |    cd|    12|34    |+00005|{}");
+
+        buffer[0] = '\0';
+        fmt::format_to(sink, "{:>10.3f}|{:.2}|{:6.1f}", 3.14159, "xyz", 2.0f);
+        REQUIRE_STREQ(buffer, "     3.142|xy|   2.0");
+
+        // Custom specifiers work too.
+        fmt_install('@', conv_angle);
+        buffer[0] = '\0';
+        fmt::format_to(sink, "{:@}|{:>5@}", 7, 8);
+        REQUIRE_STREQ(buffer, "<7>|<8>");
+    }
+#endif
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    } else {
+        printf("success!\n");
+        return 0;
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// \brief Format strings that pico/fmt.hpp must refuse to compile
+//
+// Each CASE is built as its own target, which is expected to fail.
+
+#include "pico/fmt.hpp"
+#include "pico/fmt_static.hpp"
+
+struct opaque {};
+
+struct printable {};
+
+template <>
+struct fmt::formatter<printable> {
+    static void format(fmt_state *state, const printable &) {
+        fmt::convert<'d'>(state, 1);
+#if CASE == 21
+        fmt::convert<'s'>(state, 1); // integer for a string
+#endif
+    }
+};
+
+void test(void (*sink)(const char *, size_t)) {
+#if CASE == 1
+    fmt::print_to(sink, "%d %d", 1); // too few arguments
+#elif CASE == 2
+    fmt::print_to(sink, "%d", 1, 2); // too many arguments
+#elif CASE == 3
+    fmt::print_to(sink, "%s", 1); // integer for a string
+#elif CASE == 4
+    fmt::print_to(sink, "%d", "str"); // string for an integer
+#elif CASE == 5
+    fmt::print_to(sink, "%lld", 1); // wrong size
+#elif CASE == 6
+    fmt::print_to(sink, "%d", 1.0); // double for an integer
+#elif CASE == 7
+    fmt::print_to(sink, "%f", 1); // integer for a double
+#elif CASE == 8
+    fmt::print_to(sink, "%d", opaque{}); // not formattable
+#elif CASE == 9
+    fmt::print_to(sink, "%y", 1); // unknown conversion
+#elif CASE == 10
+    fmt::print_to(sink, "%*d", 1.0, 2); // width must be an int
+#elif CASE == 11
+    fmt::print_to(sink, "%s", nullptr); // %s doesn't take NULL
+#elif CASE == 12
+    fmt::format_to(sink, "{:s}", 1); // integer for a string
+#elif CASE == 13
+    fmt::format_to(sink, "{} {}", 1); // too few arguments
+#elif CASE == 14
+    fmt::format_to(sink, "{0}", 1); // argument numbers
+#elif CASE == 15
+    fmt::format_to(sink, "{:*<5}", 1); // fill other than ' '
+#elif CASE == 16
+    fmt::format_to(sink, "{:{}}", 1, 5); // dynamic width
+#elif CASE == 17
+    fmt::format_to(sink, "{", 1); // unterminated field
+#elif CASE == 18
+    static constexpr auto s = FMT_STATIC_SPRINT("%f", 1.0); // not at compile time
+#elif CASE == 19
+    static constexpr auto s = FMT_STATIC_SPRINT("%d", "str"); // string for an integer
+#elif CASE == 20
+    fmt::print_to(sink, "%d", printable{}); // formatter type for an integer
+#elif CASE == 21
+    fmt::print_to(sink, "%v", printable{});
+#elif CASE == 22
+    fmt::print_to(sink, "%R", &sink, &sink); // not built in
+#elif CASE == 23
+    fmt::format_to(sink, "{}", 1); // `{}` not built in
+#else
+    fmt::print_to(sink, "%d", 1); // control: these compile
+    fmt::format_to(sink, "{} {:x} {:>8.3f}", 1, 2L, 3.0);
+    fmt::print_to(sink, "%v %5v", printable{}, printable{});
+    static constexpr auto s = FMT_STATIC_SPRINT("%s %d", "v", 1);
+    sink(s.c_str(), s.size());
+#endif
+}
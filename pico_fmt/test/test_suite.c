@@ -36,11 +36,18 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "pico/fmt_cksum.h"
+#include "pico/fmt_diff.h"
+#include "pico/fmt_install.h"
+#include "pico/fmt_iovec.h"
+#include "pico/fmt_out.h"
 #include "pico/fmt_printf.h"
+#include "pico/fmt_struct.h"
 
 static char printf_buffer[100];
 static size_t printf_idx = 0U;
@@ -50,6 +57,26 @@ void _out_fct(char character, void *arg) {
     printf_buffer[printf_idx++] = character;
 }
 
+// Record each chunk as "|chunk".
+static char write_buffer[100];
+static size_t write_idx = 0U;
+
+void _out_write(const char *buf, size_t len, void *arg) {
+    (void) arg;
+    write_buffer[write_idx++] = '|';
+    memcpy(&write_buffer[write_idx], buf, len);
+    write_idx += len;
+    write_buffer[write_idx] = '\0';
+}
+
+// Append to the NUL-terminated string at `arg`.
+void _out_append(const char *buf, size_t len, void *arg) {
+    char *dst = arg;
+    dst += strlen(dst);
+    memcpy(dst, buf, len);
+    dst[len] = '\0';
+}
+
 int fmt_vprintf(const char *format, va_list va) [[gnu::format(printf, 1, 0)]] {
     return fmt_vfctprintf(_out_fct, NULL, format, va);
 }
@@ -89,6 +116,7 @@ int fmt_printf(const char *format, ...) [[gnu::format(printf, 1, 2)]] {
 
 #pragma GCC diagnostic ignored "-Wformat"
 #pragma GCC diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-overflow"
 
 static void vprintf_builder_1(char *buffer, ...) {
     va_list args;
@@ -111,6 +139,69 @@ static void vsnprintf_builder_3(char *buffer, ...) {
     va_end(args);
 }
 
+// Record each run of changed characters as "|offset:run".
+void _out_diff(size_t offset, const char *buf, size_t len, void *arg) {
+    char *dst = arg;
+    dst += strlen(dst);
+    dst += sprintf(dst, "|%zu:", offset);
+    memcpy(dst, buf, len);
+    dst[len] = '\0';
+}
+
+// fmt_stream_read() the output `chunk` bytes at a time in to `out`,
+// returning the number of reads; or 0 if a read other than the last
+// came up short.
+static size_t stream_chunks(char *out, size_t chunk, const char *format, ...) [[gnu::format(printf, 3, 4)]] {
+    va_list va;
+    va_start(va, format);
+    struct fmt_stream s;
+    fmt_stream_init(&s, format, va);
+    char buf[16];
+    size_t reads = 0, n;
+    bool short_read = false;
+    while ((n = fmt_stream_read(&s, buf, chunk))) {
+        if (short_read)
+            reads = (size_t) -1;
+        short_read = n < chunk;
+        memcpy(out, buf, n);
+        out += n;
+        reads++;
+    }
+    *out = '\0';
+    fmt_stream_end(&s);
+    va_end(va);
+    return reads;
+}
+
+#if PICO_PRINTF_SUPPORT_VALUE
+// Formats an `int[2]` as "(x,y)", with the width applying to each of x and y.
+static void fmt_point(struct fmt_state *state, const void *obj) {
+    const int *xy = obj;
+    const struct fmt_arg argv[] = {{.i = xy[0]}, {.i = xy[1]}};
+    fmt_state_putchar(state, '(');
+    fmt_state_convert(state, 'd', &argv[0]);
+    fmt_state_putchar(state, ',');
+    fmt_state_convert(state, 'd', &argv[1]);
+    fmt_state_putchar(state, ')');
+}
+#endif
+
+// A custom specifier that renders its int argument in to a local
+// buffer, and outputs that with a nested printf.
+static void conv_Z(struct fmt_state *state) {
+    char buf[32];
+    fmt_snprintf(buf, sizeof(buf), "[%-16d]", fmt_state_arg_int(state));
+    fmt_state_printf(state, "%s", buf);
+}
+
+#if PICO_PRINTF_SUPPORT_YIELD
+static unsigned int yields;
+
+static void count_yield(void) {
+    yields++;
+}
+#endif
+
 int main(void) {
     const char *grp_name;
     unsigned int failures = 0;
@@ -134,6 +225,28 @@ int main(void) {
         REQUIRE(printf_buffer[22] == (char) 0xCC);
     }
 
+    TEST_CASE("writeprintf", "[]");
+    {
+        write_idx = 0U;
+        REQUIRE(fmt_writeprintf(_out_write, NULL, "a%sb", "hello") == 7);
+        REQUIRE_STREQ(write_buffer, "|a|hello|b");
+
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "%-7s|%3c", "hi", 'x');
+        REQUIRE_STREQ(write_buffer, "|hi|     |||  |x");
+
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "%.3s%.0s", "abcdef", "ghi");
+        REQUIRE_STREQ(write_buffer, "|abc");
+
+        // runs of literal text are written at once, too
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "id=%s, n=%d\n", "x", 42);
+        REQUIRE_STREQ(write_buffer, "|id=|x|, n=|4|2|\n");
+
+        REQUIRE(fmt_writeprintf(NULL, NULL, "%20s", "x") == 20);
+    }
+
     TEST_CASE("snprintf", "[]");
     {
         char buffer[100];
@@ -1440,6 +1553,16 @@ int main(void) {
 
     TEST_CASE("string length", "[]");
     {
+        // every alignment and every bound, for the word-at-a-time scan
+        static const char str[] = "0123456789abcdefghijklmnopqrstuv";
+        for (unsigned off = 0; off < 8; off++) {
+            for (int prec = 0; prec < 30; prec++) {
+                const int len = (int) sizeof(str) - 1 - (int) off;
+                REQUIRE(fmt_snprintf(NULL, 0, "%.*s", prec, &str[off]) == (prec < len ? prec : len));
+                REQUIRE(fmt_snprintf(NULL, 0, "%s", &str[off]) == len);
+            }
+        }
+
         char buffer[100];
 
         fmt_sprintf(buffer, "%.4s", "This is a test");
@@ -1542,6 +1665,18 @@ int main(void) {
         fmt_sprintf(buffer, "%*sx", -3, "hi");
         REQUIRE_STREQ(buffer, "hi x");
 
+        fmt_sprintf(buffer, "%.*d", -1, 0);
+        REQUIRE_STREQ(buffer, "0");
+
+        fmt_sprintf(buffer, "[%6x][%-6d][%06d][%+4d]", 0, 0, 0, 0);
+        REQUIRE_STREQ(buffer, "[     0][0     ][000000][  +0]");
+
+        fmt_sprintf(buffer, "%d", INT32_MIN);
+        REQUIRE_STREQ(buffer, "-2147483648");
+
+        fmt_sprintf(buffer, "abc%");
+        REQUIRE_STREQ(buffer, "abc%!(unknown specifier='\\x00')");
+
 #if PICO_PRINTF_SUPPORT_FLOAT && PICO_PRINTF_SUPPORT_EXPONENTIAL
         fmt_sprintf(buffer, "%.*g", 2, 0.33333333);
         REQUIRE_STREQ(buffer, "0.33");
@@ -1551,6 +1686,643 @@ int main(void) {
 #endif
     }
 
+#if PICO_PRINTF_SUPPORT_UTF8
+    TEST_CASE("utf8", "[]");
+    {
+        char buffer[100];
+        static const char hello[] = "h\xc3\xa9llo"; // "héllo"; 6 bytes, 5 code points
+
+        fmt_sprintf(buffer, "%7s|%#7s|%#-7s|%#3s|", hello, hello, hello, hello);
+        REQUIRE_STREQ(buffer, " h\xc3\xa9llo|  h\xc3\xa9llo|h\xc3\xa9llo  |h\xc3\xa9llo|");
+
+        fmt_sprintf(buffer, "%.2s|%#.2s|%#.3s|%#-4.2s|", hello, hello, hello, hello);
+        REQUIRE_STREQ(buffer, "h\xc3|h|h\xc3\xa9|h   |");
+
+        // a 4-byte sequence at every alignment, within a long ASCII run
+        static const char ascii[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+        char str[sizeof(ascii) + 4];
+        char expect[sizeof(ascii) + 8];
+        for (size_t i = 0; i < sizeof(ascii); i++) {
+            fmt_sprintf(str, "%.*s\xf0\x9f\x98\x80%s", (int) i, ascii, &ascii[i]);
+            fmt_sprintf(expect, "  %s|", str);
+            fmt_sprintf(buffer, "%#*s|", (int) sizeof(ascii) + 2, str);
+            REQUIRE_STREQ(buffer, expect);
+
+            fmt_sprintf(buffer, "%#.*s|", (int) i + 3, str);
+            fmt_sprintf(expect, "%.*s|", (int) i, str);
+            REQUIRE_STREQ(buffer, expect);
+        }
+
+        // the precision may be the size of an array that is not
+        // NUL-terminated; nothing past it is looked at
+        static const struct {
+            char str[3];
+            char after;
+        } unterminated = {{'a', '\xc3', '\xa9'}, '\xa9'};
+        fmt_sprintf(buffer, "%#.3s|%#.2s|", unterminated.str, unterminated.str);
+        REQUIRE_STREQ(buffer, "a\xc3\xa9|a|");
+
+#if PICO_PRINTF_SUPPORT_SLICE
+        fmt_sprintf(buffer, "%#.2S|%#6S|", hello, sizeof(hello) - 1, hello, sizeof(hello) - 1);
+        REQUIRE_STREQ(buffer, "h| h\xc3\xa9llo|");
+#endif
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_SLICE
+    TEST_CASE("slice", "[]");
+    {
+        char buffer[100];
+        // deliberately not NUL-terminated
+        static const char slice[6] = {'a', 'b', 'c', 'd', 'e', 'f'};
+
+        fmt_sprintf(buffer, "%S|", slice, (size_t) 4);
+        REQUIRE_STREQ(buffer, "abcd|");
+
+        fmt_sprintf(buffer, "%8S|%-8S|", slice, sizeof(slice), slice, (size_t) 2);
+        REQUIRE_STREQ(buffer, "  abcdef|ab      |");
+
+        fmt_sprintf(buffer, "%.3S|%.*S|", slice, sizeof(slice), 10, slice, sizeof(slice));
+        REQUIRE_STREQ(buffer, "abc|abcdef|");
+
+        fmt_sprintf(buffer, "[%S][%3S]%d", slice, (size_t) 0, slice, (size_t) 0, 5);
+        REQUIRE_STREQ(buffer, "[][   ]5");
+
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "<%S>", slice, sizeof(slice));
+        REQUIRE_STREQ(write_buffer, "|<|abcdef|>");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_HEXDUMP
+    TEST_CASE("hexdump", "[]");
+    {
+        char buffer[300];
+        static const unsigned char bytes[4] = {0xde, 0xad, 0xbe, 0xef};
+        static const char text[] = "Hello, world! 012345";
+
+        fmt_sprintf(buffer, "%H|% H|%+.2H|", bytes, sizeof(bytes), bytes, sizeof(bytes), bytes, sizeof(bytes));
+        REQUIRE_STREQ(buffer, "deadbeef|de ad be ef|dead:beef|");
+
+        fmt_sprintf(buffer, "%12H|%-12H|% .3H|", bytes, sizeof(bytes), bytes, sizeof(bytes), bytes, sizeof(bytes));
+        REQUIRE_STREQ(buffer, "    deadbeef|deadbeef    |deadbe ef|");
+
+        fmt_sprintf(buffer, "[%H][% H][%#H]%d", bytes, (size_t) 0, bytes, (size_t) 0, bytes, (size_t) 0, 5);
+        REQUIRE_STREQ(buffer, "[][][]5");
+
+        fmt_sprintf(buffer, "%#H", text, strlen(text));
+        REQUIRE_STREQ(buffer,
+                      "00000000: 4865 6c6c 6f2c 2077 6f72 6c64 2120 3031  Hello, world! 01\n"
+                      "00000010: 3233 3435                                2345\n");
+
+        fmt_sprintf(buffer, "%#8.1H", text, strlen(text));
+        REQUIRE_STREQ(buffer,
+                      "00000000: 48 65 6c 6c 6f 2c 20 77  Hello, w\n"
+                      "00000008: 6f 72 6c 64 21 20 30 31  orld! 01\n"
+                      "00000010: 32 33 34 35              2345\n");
+
+        fmt_sprintf(buffer, "%+#4H", bytes, sizeof(bytes));
+        REQUIRE_STREQ(buffer, "00000000: dead:beef  ....\n");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_QUOTE
+    TEST_CASE("quote", "[]");
+    {
+        char buffer[200];
+
+        fmt_sprintf(buffer, "%q", "a\"b\\c\n\x01\xff'done'");
+        REQUIRE_STREQ(buffer, "\"a\\\"b\\\\c\\x0a\\x01\\xff'done'\"");
+
+        fmt_sprintf(buffer, "%12q|%-12q|%.3q|%.*q|", "a\tb", "a\tb", "abcdef", 2, "\"\"\"");
+        REQUIRE_STREQ(buffer, "    \"a\\x09b\"|\"a\\x09b\"    |\"abc\"|\"\\\"\\\"\"|");
+
+        fmt_sprintf(buffer, "[%q][%3q]%d", "", "", 5);
+        REQUIRE_STREQ(buffer, "[\"\"][ \"\"]5");
+
+        // every alignment of an escape within a long clean span
+        static const char clean[] = "0123456789abcdefghijklmnopqrstuvwxyz~ !";
+        char str[sizeof(clean)];
+        char expect[sizeof(clean) + 4];
+        for (size_t i = 0; i < sizeof(clean) - 1; i++) {
+            memcpy(str, clean, sizeof(clean));
+            str[i] = '\\';
+            fmt_sprintf(expect, "\"%.*s\\\\%s\"", (int) i, clean, &clean[i + 1]);
+            fmt_sprintf(buffer, "%q", str);
+            REQUIRE_STREQ(buffer, expect);
+        }
+
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "<%q>", "ab\"cd");
+        REQUIRE_STREQ(write_buffer, "|<|\"|ab|\\|\"|cd|\"|>");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_BASE64
+    TEST_CASE("base64", "[]");
+    {
+        char buffer[100];
+        static const char foobar[] = "foobar";
+
+        // RFC 4648 section 10 test vectors
+        fmt_sprintf(buffer, "[%r][%r][%r][%r]", foobar, (size_t) 0, foobar, (size_t) 1, foobar, (size_t) 2, foobar, (size_t) 3);
+        REQUIRE_STREQ(buffer, "[][Zg==][Zm8=][Zm9v]");
+        fmt_sprintf(buffer, "[%r][%r][%r]", foobar, (size_t) 4, foobar, (size_t) 5, foobar, (size_t) 6);
+        REQUIRE_STREQ(buffer, "[Zm9vYg==][Zm9vYmE=][Zm9vYmFy]");
+
+        static const unsigned char high[] = {0xfb, 0xff, 0xbf};
+        fmt_sprintf(buffer, "%r|%#r|%#r|", high, sizeof(high), high, sizeof(high), high, (size_t) 2);
+        REQUIRE_STREQ(buffer, "+/+/|-_-_|-_8=|");
+
+        fmt_sprintf(buffer, "%10r|%-10r|%2r|", foobar, (size_t) 3, foobar, (size_t) 3, foobar, (size_t) 3);
+        REQUIRE_STREQ(buffer, "      Zm9v|Zm9v      |Zm9v|");
+
+        unsigned char bytes[30];
+        for (size_t i = 0; i < sizeof(bytes); i++)
+            bytes[i] = (unsigned char) i;
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "<%r>", bytes, sizeof(bytes));
+        REQUIRE_STREQ(write_buffer, "|<|AAECAwQFBgcICQoLDA0ODxAREhMUFRYX|GBkaGxwd|>");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_NETADDR
+    TEST_CASE("network addresses", "[]");
+    {
+        char buffer[100];
+
+        static const unsigned char ip4[][4] = {
+            {192, 168, 1, 57},
+            {0, 0, 0, 0},
+            {255, 255, 255, 255},
+            {10, 100, 9, 200},
+        };
+        fmt_sprintf(buffer, "%I|%I|%I|%I|", ip4[0], ip4[1], ip4[2], ip4[3]);
+        REQUIRE_STREQ(buffer, "192.168.1.57|0.0.0.0|255.255.255.255|10.100.9.200|");
+        fmt_sprintf(buffer, "%16I|%-16I|", ip4[0], ip4[1]);
+        REQUIRE_STREQ(buffer, "    192.168.1.57|0.0.0.0         |");
+
+        // RFC 5952 section 4 examples
+        static const struct {
+            unsigned char addr[16];
+            const char *str;
+        } ip6[] = {
+            {{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01}, "2001:db8::1"},
+            {{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0x01, 0, 0, 0, 0, 0, 0x01}, "2001:db8::1:0:0:1"},
+            {{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0x01, 0, 0x01, 0, 0x01, 0, 0x01, 0, 0x01}, "2001:db8:0:1:1:1:1:1"},
+            {{0x20, 0x01, 0, 0, 0, 0, 0, 0x01, 0, 0, 0, 0, 0, 0, 0, 0x01}, "2001:0:0:1::1"},
+            {{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x0a, 0xbc, 0, 0, 0, 0, 0, 0x01}, "2001:db8::abc:0:0:1"},
+            {{0}, "::"},
+            {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01}, "::1"},
+            {{0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, "fe80::"},
+            {{0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"},
+            {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 192, 0, 2, 1}, "::ffff:192.0.2.1"},
+        };
+        for (size_t i = 0; i < sizeof(ip6) / sizeof(ip6[0]); i++) {
+            fmt_sprintf(buffer, "%lI", ip6[i].addr);
+            REQUIRE_STREQ(buffer, ip6[i].str);
+        }
+
+        static const unsigned char mac[6] = {0x28, 0xcd, 0xc1, 0x00, 0x4f, 0x3e};
+        fmt_sprintf(buffer, "%M|%19M|%-19M|", mac, mac, mac);
+        REQUIRE_STREQ(buffer, "28:cd:c1:00:4f:3e|  28:cd:c1:00:4f:3e|28:cd:c1:00:4f:3e  |");
+
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "<%I>", ip4[0]);
+        REQUIRE_STREQ(write_buffer, "|<|192.168.1.57|>");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_UNITS
+    TEST_CASE("units", "[]");
+    {
+        char buffer[100];
+
+        fmt_sprintf(buffer, "%K|%K|%K|%K|", 0U, 1023U, 1024U, 1536U);
+        REQUIRE_STREQ(buffer, "0 B|1023 B|1.0 KiB|1.5 KiB|");
+        fmt_sprintf(buffer, "%K|%.0K|%.3K|%K|", 1048575U, 1536U, 1536U, 3221225472U);
+        REQUIRE_STREQ(buffer, "1.0 MiB|2 KiB|1.500 KiB|3.0 GiB|");
+        fmt_sprintf(buffer, "%#K|%#K|%#K|%#.2K|", 999U, 1000U, 999950U, 1234567U);
+        REQUIRE_STREQ(buffer, "999 B|1.0 kB|1.0 MB|1.23 MB|");
+        fmt_sprintf(buffer, "%10K|%-10K|%hhK|", 1536U, 1536U, 1024U + 5U);
+        REQUIRE_STREQ(buffer, "   1.5 KiB|1.5 KiB   |5 B|");
+        // remainders of more than 2^32/10, for a 32-bit long
+        fmt_sprintf(buffer, "%K|%.3K|%#K|%#.9K|", 4294967295U, 3758096384U, 3999999999U, 3999999999U);
+        REQUIRE_STREQ(buffer, "4.0 GiB|3.500 GiB|4.0 GB|3.999999999 GB|");
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+        fmt_sprintf(buffer, "%llK|%#llK|%.9llK|", 18446744073709551615ULL, 18446744073709551615ULL, 1152921504606846977ULL);
+        REQUIRE_STREQ(buffer, "16.0 EiB|18.4 EB|1.000000000 EiB|");
+#endif
+
+        fmt_sprintf(buffer, "%T|%T|%T|", 0U, 3723456U, 59999U);
+        REQUIRE_STREQ(buffer, "0:00:00.000|1:02:03.456|0:00:59.999|");
+        fmt_sprintf(buffer, "%.1T|%.0T|%.0T|%.2T|", 59999U, 1499U, 1500U, 3599995U);
+        REQUIRE_STREQ(buffer, "0:01:00.0|0:00:01|0:00:02|1:00:00.00|");
+        fmt_sprintf(buffer, "%#T|%#T|%#T|%#.0T|", 3456U, 123456U, 3723456U, 400U);
+        REQUIRE_STREQ(buffer, "3.456|2:03.456|1:02:03.456|0|");
+        fmt_sprintf(buffer, "%14T|%-14T|%lT|", 3723456U, 3723456U, 90061001UL);
+        REQUIRE_STREQ(buffer, "   1:02:03.456|1:02:03.456   |25:01:01.001|");
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+        fmt_sprintf(buffer, "%llT", 18446744073709551615ULL);
+        REQUIRE_STREQ(buffer, "5124095576030:25:51.615");
+#endif
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_STRUCT
+    TEST_CASE("struct", "[]");
+    {
+        char buffer[200];
+
+        struct uart_cfg {
+            uint32_t baud;
+            uint8_t mode;
+            uint16_t flags;
+            int8_t trim;
+            bool enabled;
+            uint64_t id;
+            const char *label;
+            char name[8];
+        };
+        static const char *const mode_names[] = {"OFF", "RX", "TX", "RXTX"};
+        static const char *const flag_names[] = {"PARITY", NULL, "CTS", "RTS"};
+        static const struct fmt_field fields[] = {
+            FMT_FIELD(struct uart_cfg, baud, FMT_FIELD_UINT, FMT_DISPLAY_DEC),
+            FMT_FIELD_NAMES(struct uart_cfg, mode, FMT_FIELD_UINT, FMT_DISPLAY_ENUM, mode_names),
+            FMT_FIELD_NAMES(struct uart_cfg, flags, FMT_FIELD_UINT, FMT_DISPLAY_FLAGS, flag_names),
+            FMT_FIELD(struct uart_cfg, trim, FMT_FIELD_SINT, FMT_DISPLAY_DEC),
+            FMT_FIELD(struct uart_cfg, enabled, FMT_FIELD_BOOL, FMT_DISPLAY_DEC),
+            FMT_FIELD(struct uart_cfg, id, FMT_FIELD_UINT, FMT_DISPLAY_HEX),
+            FMT_FIELD(struct uart_cfg, label, FMT_FIELD_STR, FMT_DISPLAY_DEC),
+            FMT_FIELD(struct uart_cfg, name, FMT_FIELD_CHARS, FMT_DISPLAY_DEC),
+        };
+        static const struct fmt_struct desc = FMT_STRUCT(fields);
+
+        struct uart_cfg cfg = {
+            .baud = 115200,
+            .mode = 3,
+            .flags = 0x0003,
+            .trim = -12,
+            .enabled = true,
+            .id = 0xe6612813,
+            .label = "console",
+            .name = {'u', 'a', 'r', 't', '0', '1', '2', '3'}, // not NUL-terminated
+        };
+
+        fmt_sprintf(buffer, "%R", &cfg, &desc);
+        REQUIRE_STREQ(buffer, "{baud=115200, mode=RXTX, flags=PARITY|0x2, trim=-12, enabled=true, id=0x00000000e6612813, label=\"console\", name=\"uart0123\"}");
+
+        cfg.mode = 7;
+        cfg.flags = 0x000C;
+        cfg.trim = 5;
+        cfg.enabled = false;
+        cfg.label = NULL;
+        cfg.name[4] = '\0';
+        fmt_sprintf(buffer, "%#R", &cfg, &desc);
+        REQUIRE_STREQ(buffer, "baud=115200\nmode=7\nflags=CTS|RTS\ntrim=5\nenabled=false\nid=0x00000000e6612813\nlabel=NULL\nname=\"uart\"\n");
+
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "%R", &cfg, &(const struct fmt_struct){.nfields = 2, .fields = &fields[6]});
+        REQUIRE_STREQ(write_buffer, "|{|label|=|NULL|, |name|=|\"|uart|\"|}");
+
+        // packed, so that the fields are unaligned
+        struct __attribute__((packed)) wire_hdr {
+            uint8_t tag;
+            uint32_t len;
+            int16_t off;
+            const char *label;
+        };
+        static const struct fmt_field wire_fields[] = {
+            FMT_FIELD(struct wire_hdr, len, FMT_FIELD_UINT, FMT_DISPLAY_HEX),
+            FMT_FIELD(struct wire_hdr, off, FMT_FIELD_SINT, FMT_DISPLAY_DEC),
+            FMT_FIELD(struct wire_hdr, label, FMT_FIELD_STR, FMT_DISPLAY_DEC),
+        };
+        static const struct fmt_struct wire_desc = FMT_STRUCT(wire_fields);
+        const struct wire_hdr hdr = {.tag = 1, .len = 0x12345678, .off = -300, .label = "ack"};
+        fmt_sprintf(buffer, "%R", &hdr, &wire_desc);
+        REQUIRE_STREQ(buffer, "{len=0x12345678, off=-300, label=\"ack\"}");
+    }
+#endif
+
+    TEST_CASE("stream", "[]");
+    {
+        char buffer[100];
+        char expect[100];
+
+        const int len = fmt_sprintf(expect, "[%5d|%-6s|%#x|%*d|%s%%]", -42, "ab", 255U, -4, 7, "a longer string argument");
+        for (size_t chunk = 1; chunk <= 16; chunk++) {
+            const size_t reads = stream_chunks(buffer, chunk, "[%5d|%-6s|%#x|%*d|%s%%]", -42, "ab", 255U, -4, 7, "a longer string argument");
+            REQUIRE_STREQ(buffer, expect);
+            REQUIRE(reads == ((size_t) len + chunk - 1) / chunk);
+        }
+
+        REQUIRE(stream_chunks(buffer, 16, "%.0s", "x") == 0);
+        REQUIRE_STREQ(buffer, "");
+        REQUIRE(stream_chunks(buffer, 4, "%s", "") == 0);
+        REQUIRE(stream_chunks(buffer, 4, "%d%d", 1234, 5678) == 2);
+        REQUIRE_STREQ(buffer, "12345678");
+    }
+
+    TEST_CASE("window", "[]");
+    {
+        char buffer[100];
+        char expect[100];
+
+        const size_t len = (size_t) fmt_sprintf(expect, "%-8s|%5d|%#x|%s.", "name", -42, 255U, "tail");
+        for (size_t off = 0; off <= len + 1; off++) {
+            for (size_t n = 0; n <= 12; n++) {
+                const size_t want = off >= len ? 0 : (len - off < n ? len - off : n);
+                memset(buffer, '#', sizeof(buffer));
+                REQUIRE(fmt_windowprintf(buffer, off, n, "%-8s|%5d|%#x|%s.", "name", -42, 255U, "tail") == want);
+                REQUIRE(!memcmp(buffer, &expect[off < len ? off : len], want));
+                REQUIRE(buffer[want] == '#');
+            }
+        }
+    }
+
+    TEST_CASE("diff", "[]");
+    {
+        char runs[200] = "";
+        _Alignas(4) char shadow[40];
+        struct fmt_diff d;
+
+        fmt_diff_init(&d, shadow, 20, _out_diff, runs);
+        fmt_diff_printf(&d, "T=%3d RH=%2d%%", 21, 40);
+        REQUIRE(fmt_diff_end(&d) == 20);
+        REQUIRE_STREQ(runs, "|0:T= 21 RH=40%        ");
+
+        // unchanged
+        runs[0] = '\0';
+        fmt_diff_printf(&d, "T=%3d RH=%2d%%", 21, 40);
+        REQUIRE(fmt_diff_end(&d) == 0);
+        REQUIRE_STREQ(runs, "");
+
+        // two runs, one of which is in the padding
+        runs[0] = '\0';
+        fmt_diff_printf(&d, "T=%3d RH=%2d%% %s", 19, 40, "!");
+        REQUIRE(fmt_diff_end(&d) == 3);
+        REQUIRE_STREQ(runs, "|3:19|13:!");
+
+        // shorter; and past the end is dropped
+        runs[0] = '\0';
+        fmt_diff_printf(&d, "T=%3d", 19);
+        REQUIRE(fmt_diff_end(&d) == 7);
+        REQUIRE_STREQ(runs, "|6:      |13: ");
+        runs[0] = '\0';
+        fmt_diff_printf(&d, "%-25s|", "T= 19  abcdefghijklmnopq");
+        REQUIRE(fmt_diff_end(&d) == 13);
+        REQUIRE_STREQ(runs, "|7:abcdefghijklm");
+
+        // word-aligned runs of equal and unequal output
+        _Alignas(4) static const char frame1[] = "0123456789abcdefghijklmnopqrstuvwxyzABCD";
+        _Alignas(4) static const char frame2[] = "0123456789abcdefghijXXXXXXXXXXXXwxyzABCd";
+        fmt_diff_init(&d, shadow, 40, _out_diff, runs);
+        fmt_diff_printf(&d, "%s", frame1);
+        fmt_diff_end(&d);
+        runs[0] = '\0';
+        fmt_diff_printf(&d, "%s", frame2);
+        REQUIRE(fmt_diff_end(&d) == 13);
+        REQUIRE_STREQ(runs, "|20:XXXXXXXXXXXX|39:d");
+    }
+
+    TEST_CASE("out", "[]");
+    {
+        char buf[8];
+        struct fmt_out o;
+        fmt_out_init(&o, buf, sizeof(buf), _out_write, NULL);
+
+        // small prints are coalesced
+        write_idx = 0U;
+        write_buffer[0] = '\0';
+        REQUIRE(fmt_out_printf(&o, "%d,", 1) == 2);
+        fmt_out_printf(&o, "%d,", 22);
+        fmt_out_printf(&o, "%s", "x");
+        REQUIRE_STREQ(write_buffer, "");
+        fmt_out_printf(&o, "%d;", 333);
+        REQUIRE_STREQ(write_buffer, "|1,22,x33");
+        fmt_out_flush(&o);
+        REQUIRE_STREQ(write_buffer, "|1,22,x33|3;");
+        fmt_out_flush(&o);
+        REQUIRE_STREQ(write_buffer, "|1,22,x33|3;");
+
+        // big runs go straight through when they can
+        fmt_out_printf(&o, "%s|%s", "0123456789", "abcdefghij");
+        REQUIRE_STREQ(write_buffer, "|1,22,x33|3;|0123456789||abcdefg");
+        fmt_out_flush(&o);
+        REQUIRE_STREQ(write_buffer, "|1,22,x33|3;|0123456789||abcdefg|hij");
+        REQUIRE(fmt_out_count(&o) == 31);
+    }
+
+    TEST_CASE("iovec", "[]");
+    {
+        static const char body[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+        char scratch[24];
+        struct fmt_iov iov[4];
+        struct fmt_iovec v;
+
+        // short runs and generated characters are copied; long ones referred to
+        fmt_iovec_init(&v, iov, 4, scratch, sizeof(scratch));
+        REQUIRE(fmt_iovec_printf(&v, "n=%d s=%s;", 42, body) == 44);
+        REQUIRE(fmt_iovec_count(&v) == 3);
+        REQUIRE(iov[0].base == scratch);
+        REQUIRE(iov[0].len == 7);
+        REQUIRE(iov[1].base == body);
+        REQUIRE(iov[1].len == 36);
+        REQUIRE(iov[2].base == &scratch[7]);
+        REQUIRE(iov[2].len == 1);
+        REQUIRE(!strncmp(iov[0].base, "n=42 s=", 7));
+        REQUIRE(!fmt_iovec_truncated(&v));
+
+        // padding is generated; runs that are next to each other are merged
+        fmt_iovec_init(&v, iov, 4, scratch, sizeof(scratch));
+        fmt_iovec_ref(body, 20, &v);
+        fmt_iovec_printf(&v, "%-20.16s|", &body[20]);
+        REQUIRE(fmt_iovec_count(&v) == 2);
+        REQUIRE(iov[0].base == body);
+        REQUIRE(iov[0].len == 36);
+        REQUIRE(iov[1].base == scratch);
+        REQUIRE(iov[1].len == 5);
+        REQUIRE(!strncmp(iov[1].base, "    |", 5));
+
+        // once something is dropped, everything after it is too
+        fmt_iovec_init(&v, iov, 2, scratch, sizeof(scratch));
+        REQUIRE(fmt_iovec_printf(&v, "%s%d%s%d", body, 1, &body[1], 2) == 73);
+        REQUIRE(fmt_iovec_count(&v) == 2);
+        REQUIRE(iov[1].base == scratch);
+        REQUIRE(iov[1].len == 1);
+        REQUIRE(fmt_iovec_truncated(&v));
+
+        // a nested printf's output is copied, as its arguments are gone
+        // by the time that the list is sent
+        fmt_install('Z', conv_Z);
+        fmt_iovec_init(&v, iov, 4, scratch, sizeof(scratch));
+        REQUIRE(fmt_iovec_printf(&v, "x=%Z\n", 42) == 21);
+        REQUIRE(fmt_iovec_count(&v) == 1);
+        REQUIRE(iov[0].base == scratch);
+        REQUIRE(iov[0].len == 21);
+        REQUIRE(!strncmp(iov[0].base, "x=[42              ]\n", 21));
+    }
+
+    TEST_CASE("cksum", "[]");
+    {
+        char buffer[100] = {0};
+        struct fmt_cksum ck;
+
+        // the NMEA 0183 checksum covers everything between '$' and '*'
+        fmt_cksum_init(&ck, FMT_CKSUM_XOR8, _out_append, buffer);
+        _out_append("$", 1, buffer);
+        fmt_cksum_printf(&ck, "GPGGA,%06d,%s,N,%s,E,%d,%02d,%s,%s,M,%s,M,,", 123519, "4807.038", "01131.000", 1, 8, "0.9", "545.4", "46.9");
+        REQUIRE(fmt_cksum_value(&ck) == 0x47U);
+        fmt_cksum_end(&ck, "*%02X\r\n");
+        REQUIRE_STREQ(buffer, "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n");
+        REQUIRE(fmt_cksum_value(&ck) == 0U);
+
+        // the "123456789" check values, fed in several chunks
+        fmt_cksum_init(&ck, FMT_CKSUM_CRC16, NULL, NULL);
+        fmt_cksum_printf(&ck, "%s%d", "1234", 56789);
+        REQUIRE(fmt_cksum_value(&ck) == 0x906EU);
+        fmt_cksum_init(&ck, FMT_CKSUM_CRC32, NULL, NULL);
+        fmt_cksum_printf(&ck, "%s%d", "1234", 56789);
+        REQUIRE(fmt_cksum_value(&ck) == 0xCBF43926U);
+    }
+
+#if PICO_PRINTF_SUPPORT_BRACES
+    TEST_CASE("braces", "[]");
+    {
+        char buffer[100] = "";
+        REQUIRE(fmt_writeformat(_out_append, buffer, "{:d}|{:>5d}|{:<5d}|{:+d}|{:05d}", 1, 2, 3, 4, 5) == 22);
+        REQUIRE_STREQ(buffer, "1|    2|3    |+4|00005");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{:#x}|{: d}|{:lu}|{:hhu}|{:zu}", 255, 6, 1234567890UL, 257, sizeof(int));
+        REQUIRE_STREQ(buffer, "0xff| 6|1234567890|1|4");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{:6s}|{:>6s}|{: <3c}|{:.2s}|{{{:s}}}", "ab", "cd", 'q', "xyz", "lit");
+        REQUIRE_STREQ(buffer, "ab    |    cd|q  |xy|{lit}");
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{:>10.3f}|{:<8.1f}|", 3.14159, -2.5);
+        REQUIRE_STREQ(buffer, "     3.142|-2.5    |");
+#endif
+
+        // A va_list doesn't have types, so `{}` needs one.
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "a{}b", 1);
+        REQUIRE_STREQ(buffer, "a%!(bad replacement field)");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "a{0:d}b", 1);
+        REQUIRE_STREQ(buffer, "a%!(bad replacement field)");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "a}b");
+        REQUIRE_STREQ(buffer, "a%!(bad replacement field)");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{:d", 1);
+        REQUIRE_STREQ(buffer, "%!(bad replacement field)");
+
+        // a format that ends in the middle of a field
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{:", 1);
+        REQUIRE_STREQ(buffer, "%!(bad replacement field)");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{:5", 1);
+        REQUIRE_STREQ(buffer, "%!(bad replacement field)");
+
+        buffer[0] = '\0';
+        fmt_writeformat(_out_append, buffer, "{", 1);
+        REQUIRE_STREQ(buffer, "%!(bad replacement field)");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_VALUE
+    TEST_CASE("value", "[]");
+    {
+        char buffer[100];
+        const int xy[] = {1, -2};
+
+        REQUIRE(fmt_sprintf(buffer, "%v|%3v|%-3v|%d", fmt_point, xy, fmt_point, xy, fmt_point, xy, 7) == 28);
+        REQUIRE_STREQ(buffer, "(1,-2)|(  1, -2)|(1  ,-2 )|7");
+
+        struct fmt_arg argv[] = {{.fn = fmt_point}, {.p = xy}, {.i = 8}, {.p = NULL}};
+        buffer[0] = '\0';
+        fmt_writeprintf_argv(_out_append, buffer, "%+v|%d", argv);
+        REQUIRE_STREQ(buffer, "(+1,-2)|8");
+    }
+#endif
+
+#if PICO_PRINTF_SUPPORT_YIELD
+    TEST_CASE("yield", "[]");
+    {
+        char buffer[100];
+
+        fmt_set_yield(count_yield, 4);
+        yields = 0;
+        fmt_sprintf(buffer, "abcdefghij");
+        REQUIRE_STREQ(buffer, "abcdefghij");
+        REQUIRE(yields == 2);
+
+        yields = 0;
+        fmt_sprintf(buffer, "%10s", "x");
+        REQUIRE(yields == 2);
+
+        yields = 0;
+        fmt_snprintf(NULL, 0, "%100s", "x");
+        REQUIRE(yields == 0);
+
+        yields = 0;
+        write_idx = 0U;
+        fmt_writeprintf(_out_write, NULL, "%s", "abcdefghij");
+        REQUIRE_STREQ(write_buffer, "|abcd|efgh|ij");
+        REQUIRE(yields == 2);
+
+        fmt_set_yield(count_yield, 0);
+        yields = 0;
+        fmt_sprintf(buffer, "a%db%sc%%", 1, "two");
+        REQUIRE_STREQ(buffer, "a1btwoc%");
+        REQUIRE(yields == 3);
+
+        fmt_set_yield(NULL, 4);
+        yields = 0;
+        fmt_sprintf(buffer, "abcdefghij%d", 1);
+        REQUIRE(yields == 0);
+    }
+#endif
+
+#if PICO_PRINTF_MAX_WIDTH
+    TEST_CASE("max width", "[]");
+    {
+        char buffer[100];
+
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%*d", PICO_PRINTF_MAX_WIDTH, 1) == PICO_PRINTF_MAX_WIDTH);
+
+        fmt_sprintf(buffer, "%*d|%d", PICO_PRINTF_MAX_WIDTH + 1, 5, 6);
+        REQUIRE_STREQ(buffer, "%!(exceeded PICO_PRINTF_MAX_WIDTH)|6");
+
+        fmt_sprintf(buffer, "%*s|%s", -(PICO_PRINTF_MAX_WIDTH + 1), "x", "y");
+        REQUIRE_STREQ(buffer, "%!(exceeded PICO_PRINTF_MAX_WIDTH)|y");
+    }
+#endif
+
+#if PICO_PRINTF_MAX_PRECISION
+    TEST_CASE("max precision", "[]");
+    {
+        char buffer[100];
+
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%.*d", PICO_PRINTF_MAX_PRECISION, 1) == PICO_PRINTF_MAX_PRECISION);
+
+        fmt_sprintf(buffer, "%.*d|%d", PICO_PRINTF_MAX_PRECISION + 1, 5, 6);
+        REQUIRE_STREQ(buffer, "%!(exceeded PICO_PRINTF_MAX_PRECISION)|6");
+
+        fmt_sprintf(buffer, "%.*s|%.*s", -1, "x", PICO_PRINTF_MAX_PRECISION + 1, "y");
+        REQUIRE_STREQ(buffer, "x|%!(exceeded PICO_PRINTF_MAX_PRECISION)");
+    }
+#endif
+
     if (failures) {
         printf("%u failures\n", failures);
         return 1;